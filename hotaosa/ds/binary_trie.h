@@ -3,33 +3,193 @@
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace hotaosa {
 
 // BinaryTrie stores unsigned integers (multiset semantics) in O(kNumBits) per
 // operation. The trie is parameterised by ValueType and the number of tracked
-// bits, and supports a lazy XOR mask for whole-set toggling.
+// bits, and supports a lazy XOR mask for whole-set toggling. Nodes emptied by
+// Erase are unlinked and recycled, so memory tracks the live size. Nodes also
+// count their distinct values, and the smallest and largest values are
+// cached, so DistinctCount, Min and Max are O(1) between XOR updates.
+//
+// Besides the global mask, every node carries a lazy XOR tag for its subtree:
+// a set bit at the node's own level swaps its children, lower bits are pushed
+// down on mutation. Read-only walks fold tags into their running mask instead
+// of pushing, so const queries stay const. MergeFrom unions two tries with
+// different masks through these tags, and XorPrefix/XorRange set them to
+// toggle the low bits of a prefix subtree or of a range's aligned blocks.
+// Tries constructed on one shared NodePool merge by relinking nodes, which
+// makes bottom-up merging over a rooted tree linear in its total size.
+//
+// MakeCheckpoint starts an undo log of node writes, allocations and mask
+// changes made by Insert, Erase, PopMin/PopMax and the Xor* updates, so
+// Rollback restores an earlier state in time proportional to the undone work.
+//
+// With kTrackSums, every node also counts the set bits of its values per bit
+// position. Sums stay exact under XorAll because flipping bit b only swaps
+// that position's ones and zeros, which enables the Sum* queries at the cost
+// of kNumBits counters per node and O(kNumBits^2) updates.
 template <std::unsigned_integral ValueType,
           int kNumBits = std::numeric_limits<ValueType>::digits,
-          std::integral CountType = int>
+          std::integral CountType = int,
+          bool kTrackSums = false>
 class BinaryTrie {
   static_assert(kNumBits > 0, "BinaryTrie requires at least one bit");
   static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
                 "BinaryTrie bit width exceeds ValueType digits");
 
  public:
-  BinaryTrie() : nodes_(1) {}
+  // Multiplicities below, at and above a probe value.
+  struct RankResult {
+    CountType less;
+    CountType equal;
+    CountType greater;
+  };
+
+  // Forward iterator over the distinct stored values in increasing order,
+  // yielding (value, multiplicity) pairs as seen through the XOR mask. Any
+  // mutation of the trie invalidates it. Each step is amortized O(1) over a
+  // full scan and O(kNumBits) worst case.
+  class ConstIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<ValueType, CountType>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    ConstIterator() = default;
+
+    reference operator*() const { return current_; }
+    pointer operator->() const { return &current_; }
+
+    ConstIterator& operator++() {
+      Advance();
+      return *this;
+    }
+    ConstIterator operator++(int) {
+      ConstIterator previous = *this;
+      Advance();
+      return previous;
+    }
+
+    friend bool operator==(const ConstIterator& lhs, const ConstIterator& rhs) {
+      return lhs.leaf_ == rhs.leaf_;
+    }
+
+   private:
+    friend class BinaryTrie;
+
+    // A subtree still to visit: it decides bits [0, level), `mask` includes
+    // its own tag and `prefix` holds its higher bits.
+    struct Frame {
+      int node_index;
+      int level;
+      ValueType mask;
+      ValueType prefix;
+    };
+
+    explicit ConstIterator(const BinaryTrie* trie) : trie_(trie) {
+      if (trie_->TotalCount() > 0) {
+        stack_[size_++] = {
+            trie_->root_, kNumBits, trie_->xor_mask_, ValueType{0}};
+      }
+      Advance();
+    }
+
+    // Pops frames, pushing the actual-1 child below the actual-0 child, until
+    // a leaf surfaces. The stack holds at most one pending sibling per level.
+    void Advance() {
+      while (size_ > 0) {
+        const Frame frame = stack_[--size_];
+        if (frame.level == 0) {
+          leaf_ = frame.node_index;
+          current_ = {frame.prefix,
+                      trie_->pool_->nodes_[frame.node_index].terminal_count};
+          return;
+        }
+        const int bit = frame.level - 1;
+        for (int actual_bit = 1; actual_bit >= 0; --actual_bit) {
+          const int child = trie_->ChildForActualBit(
+              frame.node_index, bit, actual_bit, frame.mask);
+          if (trie_->SubtreeCount(child) > 0) {
+            const ValueType prefix = static_cast<ValueType>(
+                frame.prefix | (static_cast<ValueType>(actual_bit) << bit));
+            stack_[size_++] = {
+                child, bit,
+                static_cast<ValueType>(frame.mask ^
+                                       trie_->pool_->nodes_[child].xor_tag),
+                prefix};
+          }
+        }
+      }
+      leaf_ = kNull;
+    }
+
+    const BinaryTrie* trie_ = nullptr;
+    std::array<Frame, kNumBits + 1> stack_{};
+    int size_ = 0;
+    int leaf_ = kNull;
+    value_type current_{};
+  };
+
+  // Position in the undo log; see MakeCheckpoint.
+  using Checkpoint = std::size_t;
+
+  // Node storage that several tries can share, so MergeFrom can relink
+  // nodes between them instead of copying.
+  class NodePool;
+
+  BinaryTrie() : BinaryTrie(std::make_shared<NodePool>()) {}
+
+  // Creates an empty trie whose nodes live in `pool`, which other tries may
+  // share. O(1).
+  explicit BinaryTrie(std::shared_ptr<NodePool> pool) : pool_(std::move(pool)) {
+    assert(pool_ != nullptr);
+    root_ = NewNode();
+  }
+
+  // Builds the trie from `values` (duplicates allowed) in one pass over
+  // their sorted order, creating nodes in DFS order. The input is radix
+  // sorted unless it already is. O(N * kNumBits / 8 + number of nodes).
+  explicit BinaryTrie(std::vector<ValueType> values) : BinaryTrie() {
+    if (!std::is_sorted(values.begin(), values.end())) {
+      RadixSort(values);
+    }
+    BuildFromSorted(values);
+    RefreshExtremes();
+  }
 
   BinaryTrie(const BinaryTrie&) = delete;
   BinaryTrie& operator=(const BinaryTrie&) = delete;
-  BinaryTrie(BinaryTrie&&) = delete;
-  BinaryTrie& operator=(BinaryTrie&&) = delete;
+  // Moved-from tries are left empty.
+  BinaryTrie(BinaryTrie&& other) : BinaryTrie() { Swap(other); }
+  BinaryTrie& operator=(BinaryTrie&& other) {
+    if (this != &other) {
+      BinaryTrie moved(std::move(other));
+      Swap(moved);
+    }
+    return *this;
+  }
+  // Returns the nodes to the pool when other tries still share it.
+  ~BinaryTrie() {
+    if (pool_.use_count() > 1 && root_ != kNull) {
+      ReleaseSubtree(root_);
+    }
+  }
 
   // Inserts one copy of `value`. O(kNumBits).
   void Insert(ValueType value) { Insert(value, static_cast<CountType>(1)); }
@@ -41,20 +201,42 @@ class BinaryTrie {
       return;
     }
     assert((value & ~BitMask()) == 0);
-    const ValueType stored_value = ToStored(value);
-    int node_index = 0;
-    nodes_[node_index].subtree_count += count;
+    std::array<int, kNumBits + 1> path{};
+    ValueType mask = xor_mask_;
+    int node_index = root_;
+    path[0] = node_index;
+    LogNode(node_index);
+    pool_->nodes_[node_index].subtree_count += count;
+    AddBitCounts(node_index, (value ^ mask) & LowBits(kNumBits), count);
     for (int bit = kNumBits - 1; bit >= 0; --bit) {
-      const int direction = static_cast<int>((stored_value >> bit) & 1);
-      int child_index = nodes_[node_index].children[direction];
+      const int direction = static_cast<int>(((value ^ mask) >> bit) & 1);
+      int child_index = pool_->nodes_[node_index].children[direction];
       if (child_index == kNull) {
         child_index = NewNode();
-        nodes_[node_index].children[direction] = child_index;
+        pool_->nodes_[node_index].children[direction] = child_index;
       }
       node_index = child_index;
-      nodes_[node_index].subtree_count += count;
+      path[kNumBits - bit] = node_index;
+      LogNode(node_index);
+      pool_->nodes_[node_index].subtree_count += count;
+      AddBitCounts(node_index, (value ^ mask) & LowBits(bit), count);
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    if (pool_->nodes_[node_index].terminal_count == 0) {
+      for (const int path_node : path) {
+        ++pool_->nodes_[path_node].distinct_count;
+      }
+    }
+    pool_->nodes_[node_index].terminal_count += count;
+    if (!extremes_valid_) {
+      RefreshExtremes();
+    } else if (TotalCount() == count) {
+      min_value_ = value;
+      max_value_ = value;
+    } else {
+      min_value_ = std::min(min_value_, value);
+      max_value_ = std::max(max_value_, value);
     }
-    nodes_[node_index].terminal_count += count;
   }
 
   // Removes one copy of `value` when present. O(kNumBits).
@@ -67,48 +249,72 @@ class BinaryTrie {
       return;
     }
     assert((value & ~BitMask()) == 0);
-    const ValueType stored_value = ToStored(value);
+    // views[d]: `value` as seen from the parent of path[d].
     std::array<int, kNumBits + 1> path{};
-    int node_index = 0;
+    std::array<ValueType, kNumBits + 1> views{};
+    ValueType mask = xor_mask_;
+    int node_index = root_;
     path[0] = node_index;
+    views[0] = value ^ mask;
     for (int bit = kNumBits - 1; bit >= 0; --bit) {
-      const int direction = static_cast<int>((stored_value >> bit) & 1);
-      const int child_index = nodes_[node_index].children[direction];
+      const int direction = static_cast<int>(((value ^ mask) >> bit) & 1);
+      const int child_index = pool_->nodes_[node_index].children[direction];
       if (child_index == kNull) {
         return;
       }
       node_index = child_index;
       path[kNumBits - bit] = node_index;
+      views[kNumBits - bit] = value ^ mask;
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
     const CountType removable =
-        std::min(count, nodes_[node_index].terminal_count);
+        std::min(count, pool_->nodes_[node_index].terminal_count);
     if (removable == 0) {
       return;
     }
-    nodes_[node_index].terminal_count -= removable;
+    if (recording_) {
+      for (const int path_node : path) {
+        LogNode(path_node);
+      }
+    }
+    pool_->nodes_[node_index].terminal_count -= removable;
+    const bool value_gone = pool_->nodes_[node_index].terminal_count == 0;
     for (int depth = kNumBits; depth >= 0; --depth) {
-      nodes_[path[depth]].subtree_count -= removable;
+      pool_->nodes_[path[depth]].subtree_count -= removable;
+      if (value_gone) {
+        --pool_->nodes_[path[depth]].distinct_count;
+      }
+      AddBitCounts(path[depth],
+                   views[depth] & LowBits(kNumBits - depth),
+                   -removable);
+    }
+    ReclaimEmptyPath(path, views);
+    if (!extremes_valid_ ||
+        (value_gone && (value == min_value_ || value == max_value_))) {
+      RefreshExtremes();
     }
   }
 
   // Returns the multiplicity of `value` stored in the trie. O(kNumBits).
   [[nodiscard]] CountType Count(ValueType value) const {
     assert((value & ~BitMask()) == 0);
-    const ValueType stored_value = ToStored(value);
-    int node_index = 0;
+    ValueType mask = xor_mask_;
+    int node_index = root_;
     for (int bit = kNumBits - 1; bit >= 0; --bit) {
-      const int direction = static_cast<int>((stored_value >> bit) & 1);
-      const int child_index = nodes_[node_index].children[direction];
-      if (child_index == kNull) {
+      const int actual_bit = static_cast<int>((value >> bit) & 1);
+      node_index = ChildForActualBit(node_index, bit, actual_bit, mask);
+      if (node_index == kNull) {
         return static_cast<CountType>(0);
       }
-      node_index = child_index;
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
-    return nodes_[node_index].terminal_count;
+    return pool_->nodes_[node_index].terminal_count;
   }
 
   // Total multiplicity stored in the trie. O(1).
-  [[nodiscard]] CountType TotalCount() const { return nodes_[0].subtree_count; }
+  [[nodiscard]] CountType TotalCount() const {
+    return pool_->nodes_[root_].subtree_count;
+  }
 
   // Returns whether the multiset currently contains `value`. O(kNumBits).
   [[nodiscard]] bool Contains(ValueType value) const {
@@ -118,132 +324,678 @@ class BinaryTrie {
   // Returns how many stored values are strictly less than `value`. O(kNumBits).
   [[nodiscard]] CountType CountLess(ValueType value) const {
     assert((value & ~BitMask()) == 0);
-    CountType result = 0;
-    int node_index = 0;
-    for (int bit = kNumBits - 1; bit >= 0 && node_index != kNull; --bit) {
-      const int mask_bit = static_cast<int>((xor_mask_ >> bit) & 1);
-      const int zero_child = nodes_[node_index].children[mask_bit];
-      const int one_child = nodes_[node_index].children[mask_bit ^ 1];
-      const int actual_bit = static_cast<int>((value >> bit) & 1);
-      if (actual_bit == 1) {
-        result += SubtreeCount(zero_child);
-        node_index = one_child;
-      } else {
-        node_index = zero_child;
-      }
-    }
-    return result;
+    return CountLessUnderMask(value, xor_mask_);
+  }
+
+  // Returns how many stored elements e satisfy (e XOR `key`) < `value`,
+  // without touching the shared mask. O(kNumBits).
+  [[nodiscard]] CountType CountXorLess(ValueType key, ValueType value) const {
+    assert((key & ~BitMask()) == 0);
+    assert((value & ~BitMask()) == 0);
+    return CountLessUnderMask(value, xor_mask_ ^ key);
   }
 
   // Returns how many stored values are strictly greater than `value`.
   // O(kNumBits).
   [[nodiscard]] CountType CountGreater(ValueType value) const {
-    const CountType less = CountLess(value);
-    const CountType equal = Count(value);
-    return static_cast<CountType>(TotalCount() - less - equal);
+    return Rank(value).greater;
   }
 
-  // Returns the k-th smallest value (0-indexed). O(kNumBits).
-  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
-    if (k < 0) {
-      return std::nullopt;
-    }
-    const CountType total = TotalCount();
-    if (total <= 0) {
-      return std::nullopt;
+  // Returns the multiplicities of values below, equal to and above `value`
+  // in a single descent. O(kNumBits).
+  [[nodiscard]] RankResult Rank(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    RankResult result{0, 0, 0};
+    ValueType mask = xor_mask_;
+    int node_index = root_;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int actual_bit = static_cast<int>((value >> bit) & 1);
+      const int sibling =
+          ChildForActualBit(node_index, bit, actual_bit ^ 1, mask);
+      if (actual_bit == 1) {
+        result.less += SubtreeCount(sibling);
+      } else {
+        result.greater += SubtreeCount(sibling);
+      }
+      node_index = ChildForActualBit(node_index, bit, actual_bit, mask);
+      if (node_index == kNull) {
+        return result;
+      }
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
-    using UnsignedCount = std::make_unsigned_t<CountType>;
-    const auto target = static_cast<UnsignedCount>(k);
-    const auto total_unsigned = static_cast<UnsignedCount>(total);
-    if (target >= total_unsigned) {
-      return std::nullopt;
+    result.equal = pool_->nodes_[node_index].terminal_count;
+    return result;
+  }
+
+  // Returns how many stored values lie in the closed range [lo, hi]. Walks
+  // the common prefix of the bounds once, then splits. O(kNumBits).
+  [[nodiscard]] CountType CountInRange(ValueType lo, ValueType hi) const {
+    assert((lo & ~BitMask()) == 0);
+    assert((hi & ~BitMask()) == 0);
+    if (hi < lo) {
+      return static_cast<CountType>(0);
     }
-    int node_index = 0;
-    ValueType stored_value = 0;
-    UnsignedCount remaining = target;
+    ValueType mask = xor_mask_;
+    int node_index = root_;
     for (int bit = kNumBits - 1; bit >= 0; --bit) {
-      const int mask_bit = static_cast<int>((xor_mask_ >> bit) & 1);
-      const int zero_child = nodes_[node_index].children[mask_bit];
-      const auto zero_count =
-          static_cast<UnsignedCount>(SubtreeCount(zero_child));
-      if (remaining < zero_count) {
-        node_index = zero_child;
-        if (mask_bit == 1) {
-          stored_value |= (ValueType{1} << bit);
-        }
-        continue;
-      }
-      remaining -= zero_count;
-      const int one_child = nodes_[node_index].children[mask_bit ^ 1];
-      if (one_child == kNull || SubtreeCount(one_child) <= 0) {
-        return std::nullopt;
+      const int lo_bit = static_cast<int>((lo >> bit) & 1);
+      if (lo_bit != static_cast<int>((hi >> bit) & 1)) {
+        const int lo_child = ChildForActualBit(node_index, bit, 0, mask);
+        const int hi_child = ChildForActualBit(node_index, bit, 1, mask);
+        return CountTowardSide(lo_child, bit - 1, lo, mask, true) +
+               CountTowardSide(hi_child, bit - 1, hi, mask, false);
       }
-      node_index = one_child;
-      if ((mask_bit ^ 1) == 1) {
-        stored_value |= (ValueType{1} << bit);
+      node_index = ChildForActualBit(node_index, bit, lo_bit, mask);
+      if (node_index == kNull) {
+        return static_cast<CountType>(0);
       }
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
-    return ToActual(stored_value);
+    return pool_->nodes_[node_index].terminal_count;
+  }
+
+  // Returns the k-th smallest value (0-indexed). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    return KthUnderMask(k, xor_mask_);
+  }
+
+  // Returns the k-th smallest (0-indexed) of (element XOR `key`) without
+  // touching the shared mask. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> KthXor(ValueType key,
+                                                CountType k) const {
+    assert((key & ~BitMask()) == 0);
+    return KthUnderMask(k, xor_mask_ ^ key);
   }
 
   // Returns minimal value >= `value`. O(kNumBits).
   [[nodiscard]] std::optional<ValueType> LowerBound(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/true, /*inclusive=*/true);
+  }
+
+  // Returns minimal value > `value`. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> UpperBound(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/true, /*inclusive=*/false);
+  }
+
+  // Returns maximal value <= `value`. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Prev(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/false, /*inclusive=*/true);
+  }
+
+  // Returns the strict successor of `value`, i.e. minimal value > `value`.
+  // Same as UpperBound; pairs with Prev for neighbour walks. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Next(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/true, /*inclusive=*/false);
+  }
+
+  // Returns the smallest stored value. O(1), or O(kNumBits) right after an
+  // XOR update.
+  [[nodiscard]] std::optional<ValueType> Min() const {
     if (TotalCount() <= 0) {
       return std::nullopt;
     }
-    const ValueType mask = BitMask();
-    assert((value & ~mask) == 0);
-    ValueType result = 0;
-    if (!FindLowerBound(0, kNumBits - 1, value & mask, 0, true, &result)) {
-      return std::nullopt;
+    if (extremes_valid_) {
+      return min_value_;
     }
-    return result & mask;
+    return DescendToExtreme(root_, kNumBits - 1, 0, xor_mask_, false);
   }
 
-  // Returns maximal value <= `value`. O(kNumBits).
-  [[nodiscard]] std::optional<ValueType> Prev(ValueType value) const {
+  // Returns the largest stored value. O(1), or O(kNumBits) right after an
+  // XOR update.
+  [[nodiscard]] std::optional<ValueType> Max() const {
     if (TotalCount() <= 0) {
       return std::nullopt;
     }
-    const ValueType mask = BitMask();
-    assert((value & ~mask) == 0);
-    ValueType result = 0;
-    if (!FindPrev(0, kNumBits - 1, value & mask, 0, true, &result)) {
+    if (extremes_valid_) {
+      return max_value_;
+    }
+    return DescendToExtreme(root_, kNumBits - 1, 0, xor_mask_, true);
+  }
+
+  // Number of distinct values stored. O(1).
+  [[nodiscard]] CountType DistinctCount() const {
+    return pool_->nodes_[root_].distinct_count;
+  }
+
+  // Returns the k-th smallest (0-indexed) distinct value, ignoring
+  // multiplicities. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> KthDistinct(CountType k) const {
+    if (k < 0 || k >= DistinctCount()) {
       return std::nullopt;
     }
-    return result & mask;
+    ValueType mask = xor_mask_;
+    ValueType result = 0;
+    int node_index = root_;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int mask_bit = static_cast<int>((mask >> bit) & 1);
+      const int zero_child = pool_->nodes_[node_index].children[mask_bit];
+      const CountType zero_count = SubtreeDistinct(zero_child);
+      if (k < zero_count) {
+        node_index = zero_child;
+      } else {
+        k -= zero_count;
+        node_index = pool_->nodes_[node_index].children[mask_bit ^ 1];
+        result |= ValueType{1} << bit;
+      }
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    return result;
+  }
+
+  // Removes one copy of the smallest value and returns it. O(kNumBits).
+  std::optional<ValueType> PopMin() {
+    const std::optional<ValueType> result = Min();
+    if (result.has_value()) {
+      Erase(*result);
+    }
+    return result;
+  }
+
+  // Removes one copy of the largest value and returns it. O(kNumBits).
+  std::optional<ValueType> PopMax() {
+    const std::optional<ValueType> result = Max();
+    if (result.has_value()) {
+      Erase(*result);
+    }
+    return result;
   }
 
   // Returns the maximum value of (element XOR `value`). O(kNumBits).
   [[nodiscard]] std::optional<ValueType> MaxXor(ValueType value) const {
     assert((value & ~BitMask()) == 0);
-    ValueType stored = 0;
-    if (!FindExtremeXor(value & BitMask(), true, &stored)) {
-      return std::nullopt;
-    }
-    return (ToActual(stored) ^ value) & BitMask();
+    return FindExtremeXor(value, true);
   }
 
   // Returns the minimum value of (element XOR `value`). O(kNumBits).
   [[nodiscard]] std::optional<ValueType> MinXor(ValueType value) const {
     assert((value & ~BitMask()) == 0);
-    ValueType stored = 0;
-    if (!FindExtremeXor(value & BitMask(), false, &stored)) {
+    return FindExtremeXor(value, false);
+  }
+
+  // Answers MaxXor for every element of `values`. Queries advance together
+  // level by level in groups of kBatchLanes, prefetching each lane's next
+  // node, so their cache misses overlap. O(|values| * kNumBits).
+  [[nodiscard]] std::vector<std::optional<ValueType>> MaxXorBatch(
+      const std::vector<ValueType>& values) const {
+    return FindExtremeXorBatch(values, true);
+  }
+
+  // Answers MinXor for every element of `values`; see MaxXorBatch.
+  // O(|values| * kNumBits).
+  [[nodiscard]] std::vector<std::optional<ValueType>> MinXorBatch(
+      const std::vector<ValueType>& values) const {
+    return FindExtremeXorBatch(values, false);
+  }
+
+  // Answers CountLess for every element of `values`; see MaxXorBatch. A
+  // sibling's count is read one level later, after its prefetch.
+  // O(|values| * kNumBits).
+  [[nodiscard]] std::vector<CountType> CountLessBatch(
+      const std::vector<ValueType>& values) const {
+    std::vector<CountType> answers(values.size(), 0);
+    for (std::size_t begin = 0; begin < values.size(); begin += kBatchLanes) {
+      const int lanes = static_cast<int>(
+          std::min<std::size_t>(kBatchLanes, values.size() - begin));
+      std::array<int, kBatchLanes> node_indices;
+      std::array<int, kBatchLanes> pending;
+      std::array<ValueType, kBatchLanes> masks;
+      node_indices.fill(root_);
+      pending.fill(kNull);
+      masks.fill(xor_mask_);
+      for (int bit = kNumBits - 1; bit >= 0; --bit) {
+        for (int lane = 0; lane < lanes; ++lane) {
+          const ValueType value = values[begin + lane];
+          assert((value & ~BitMask()) == 0);
+          answers[begin + lane] += SubtreeCount(pending[lane]);
+          pending[lane] = kNull;
+          if (node_indices[lane] == kNull) {
+            continue;
+          }
+          const Node& node = pool_->nodes_[node_indices[lane]];
+          masks[lane] ^= node.xor_tag;
+          const int mask_bit = static_cast<int>((masks[lane] >> bit) & 1);
+          if (((value >> bit) & 1) != 0) {
+            pending[lane] = node.children[mask_bit];
+            Prefetch(pending[lane]);
+            node_indices[lane] = node.children[mask_bit ^ 1];
+          } else {
+            node_indices[lane] = node.children[mask_bit];
+          }
+          Prefetch(node_indices[lane]);
+        }
+      }
+      for (int lane = 0; lane < lanes; ++lane) {
+        answers[begin + lane] += SubtreeCount(pending[lane]);
+      }
+    }
+    return answers;
+  }
+
+  // Returns the sum of the `k` smallest values (all of them when `k` exceeds
+  // TotalCount()), accumulated in SumType. Requires kTrackSums.
+  // O(kNumBits^2).
+  template <typename SumType = std::int64_t>
+    requires kTrackSums
+  [[nodiscard]] SumType SumOfSmallest(CountType k) const {
+    if (k <= 0) {
+      return SumType{0};
+    }
+    if (k >= TotalCount()) {
+      return SubtreeSum<SumType>(root_, xor_mask_, 0, kNumBits);
+    }
+    SumType result{0};
+    ValueType mask = xor_mask_;
+    int node_index = root_;
+    ValueType actual_value = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int zero_child = ChildForActualBit(node_index, bit, 0, mask);
+      const CountType zero_count = SubtreeCount(zero_child);
+      if (k < zero_count) {
+        node_index = zero_child;
+      } else {
+        result += SubtreeSum<SumType>(zero_child, mask, actual_value, bit);
+        k -= zero_count;
+        if (k == 0) {
+          return result;
+        }
+        node_index = ChildForActualBit(node_index, bit, 1, mask);
+        actual_value |= (ValueType{1} << bit);
+      }
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    return result +
+           static_cast<SumType>(k) * static_cast<SumType>(actual_value);
+  }
+
+  // Returns the sum of stored values strictly less than `value`, accumulated
+  // in SumType. Requires kTrackSums. O(kNumBits^2).
+  template <typename SumType = std::int64_t>
+    requires kTrackSums
+  [[nodiscard]] SumType SumLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    SumType result{0};
+    ValueType mask = xor_mask_;
+    int node_index = root_;
+    for (int bit = kNumBits - 1; bit >= 0 && node_index != kNull; --bit) {
+      const int actual_bit = static_cast<int>((value >> bit) & 1);
+      if (actual_bit == 1) {
+        const int zero_child = ChildForActualBit(node_index, bit, 0, mask);
+        result += SubtreeSum<SumType>(
+            zero_child, mask, HighBits(value, bit + 1), bit);
+      }
+      node_index = ChildForActualBit(node_index, bit, actual_bit, mask);
+      if (node_index != kNull) {
+        mask ^= pool_->nodes_[node_index].xor_tag;
+      }
+    }
+    return result;
+  }
+
+  // Returns the sum of (element XOR `value`) over every stored element,
+  // accumulated in SumType. Requires kTrackSums. O(kNumBits).
+  template <typename SumType = std::int64_t>
+    requires kTrackSums
+  [[nodiscard]] SumType SumXorWith(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return SubtreeSum<SumType>(root_, xor_mask_ ^ value, 0, kNumBits);
+  }
+
+  // Returns how many unordered pairs of stored elements (distinct positions,
+  // so a value of multiplicity c forms c(c-1)/2 pairs with itself) have
+  // XOR <= `limit`, accumulated in SumType. Walks pairs of subtrees at once:
+  // a pair whose XOR prefix falls below `limit` is counted wholesale, so
+  // every node pairs with at most one partner per level. O(number of nodes).
+  template <typename SumType = std::int64_t>
+  [[nodiscard]] SumType CountPairsXorAtMost(ValueType limit) const {
+    assert((limit & ~BitMask()) == 0);
+    const PairCursor root{root_, xor_mask_};
+    return CountPairsXorAtMost<SumType>(root, root, kNumBits - 1, limit);
+  }
+
+  // Returns the k-th smallest (0-indexed) XOR over the unordered pairs of
+  // stored elements. Fixes the answer bit by bit, keeping the subtree pairs
+  // whose XOR prefix matches and counting their pairs with a zero next bit.
+  // O(number of nodes).
+  template <typename SumType = std::int64_t>
+  [[nodiscard]] std::optional<ValueType> KthPairXor(SumType k) const {
+    if (k < 0 || k >= Pairs<SumType>(TotalCount())) {
       return std::nullopt;
     }
-    return (ToActual(stored) ^ value) & BitMask();
+    std::vector<std::pair<PairCursor, PairCursor>> active = {
+        {PairCursor{root_, xor_mask_}, PairCursor{root_, xor_mask_}}};
+    std::vector<std::pair<PairCursor, PairCursor>> next;
+    ValueType result = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      SumType zero_pairs = 0;
+      for (const auto& [a, b] : active) {
+        const PairCursor a0 = ChildCursor(a, bit, 0);
+        const PairCursor a1 = ChildCursor(a, bit, 1);
+        if (a.node_index == b.node_index) {
+          zero_pairs += Pairs<SumType>(SubtreeCount(a0.node_index)) +
+                        Pairs<SumType>(SubtreeCount(a1.node_index));
+        } else {
+          zero_pairs += CrossPairs<SumType>(a0, ChildCursor(b, bit, 0)) +
+                        CrossPairs<SumType>(a1, ChildCursor(b, bit, 1));
+        }
+      }
+      const int xor_bit = k < zero_pairs ? 0 : 1;
+      if (xor_bit == 1) {
+        k -= zero_pairs;
+        result |= ValueType{1} << bit;
+      }
+      next.clear();
+      for (const auto& [a, b] : active) {
+        for (int a_bit = 0; a_bit < 2; ++a_bit) {
+          // A self pair yields its cross pair twice; keep one order.
+          if (a.node_index == b.node_index && xor_bit == 1 && a_bit == 1) {
+            continue;
+          }
+          const PairCursor a_child = ChildCursor(a, bit, a_bit);
+          const PairCursor b_child = ChildCursor(b, bit, a_bit ^ xor_bit);
+          const SumType pairs =
+              a_child.node_index == b_child.node_index
+                  ? Pairs<SumType>(SubtreeCount(a_child.node_index))
+                  : CrossPairs<SumType>(a_child, b_child);
+          if (pairs > 0) {
+            next.emplace_back(a_child, b_child);
+          }
+        }
+      }
+      active.swap(next);
+    }
+    return result;
+  }
+
+  // Returns the sum of the XORs over all unordered pairs of stored elements,
+  // accumulated in SumType. Bit b contributes (ones_b * zeros_b) << b; the
+  // per-bit counts come from the root with kTrackSums, otherwise from one
+  // walk over the nodes. O(kNumBits) with kTrackSums, else O(number of
+  // nodes).
+  template <typename SumType = std::int64_t>
+  [[nodiscard]] SumType SumPairXor() const {
+    std::array<SumType, kNumBits> ones{};
+    if constexpr (kTrackSums) {
+      for (int bit = 0; bit < kNumBits; ++bit) {
+        ones[bit] = static_cast<SumType>(pool_->nodes_[root_].bit_counts[bit]);
+      }
+    } else {
+      std::vector<std::pair<PairCursor, int>> stack = {
+          {PairCursor{root_, xor_mask_}, kNumBits - 1}};
+      while (!stack.empty()) {
+        const auto [cursor, bit] = stack.back();
+        stack.pop_back();
+        if (bit < 0) {
+          continue;
+        }
+        for (int actual_bit = 0; actual_bit < 2; ++actual_bit) {
+          const PairCursor child = ChildCursor(cursor, bit, actual_bit);
+          if (child.node_index == kNull) {
+            continue;
+          }
+          if (actual_bit == 1) {
+            ones[bit] += static_cast<SumType>(SubtreeCount(child.node_index));
+          }
+          stack.emplace_back(child, bit - 1);
+        }
+      }
+    }
+    const auto total = static_cast<SumType>(TotalCount());
+    SumType sum = 0;
+    for (int bit = 0; bit < kNumBits; ++bit) {
+      sum += (ones[bit] * (total - ones[bit])) << bit;
+    }
+    return sum;
   }
 
   // Applies XOR with `mask` lazily to every stored value. O(1).
-  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+  void XorAll(ValueType mask) {
+    if (recording_) {
+      undo_log_.push_back({UndoKind::kMask, 0, Node{}, xor_mask_});
+    }
+    xor_mask_ ^= (mask & BitMask());
+    extremes_valid_ = false;
+  }
+
+  // Applies XOR with `mask` lazily to the stored values whose top `length`
+  // bits match `prefix`; the lower bits of `prefix` are ignored. `mask` may
+  // only touch the bits below the prefix, so every value stays in its
+  // subtree and a single tag on the subtree root suffices. O(kNumBits), or
+  // O(kNumBits^2) with kTrackSums.
+  void XorPrefix(ValueType prefix, int length, ValueType mask) {
+    assert(0 <= length && length <= kNumBits);
+    assert((prefix & ~BitMask()) == 0);
+    assert((mask & ~LowBits(kNumBits - length)) == 0);
+    if (mask == 0) {
+      return;
+    }
+    if (length == 0) {
+      XorAll(mask);
+      return;
+    }
+    std::array<int, kNumBits + 1> path{};
+    ValueType view = xor_mask_;
+    int node_index = root_;
+    path[0] = node_index;
+    for (int depth = 0; depth < length; ++depth) {
+      const int bit = kNumBits - 1 - depth;
+      const int direction = static_cast<int>(((prefix ^ view) >> bit) & 1);
+      node_index = pool_->nodes_[node_index].children[direction];
+      if (node_index == kNull) {
+        return;
+      }
+      path[depth + 1] = node_index;
+      view ^= pool_->nodes_[node_index].xor_tag;
+    }
+    if (recording_) {
+      for (int depth = 0; depth <= length; ++depth) {
+        LogNode(path[depth]);
+      }
+    }
+    if constexpr (kTrackSums) {
+      // Each ancestor counts the subtree's ones in its own parent's frame,
+      // which differs from the subtree's by the tags in between.
+      const Node& target = pool_->nodes_[node_index];
+      ValueType frame = 0;
+      for (int depth = length - 1; depth >= 0; --depth) {
+        Node& ancestor = pool_->nodes_[path[depth]];
+        frame ^= ancestor.xor_tag;
+        for (ValueType rest = mask; rest != 0; rest &= rest - 1) {
+          const int bit = std::countr_zero(rest);
+          const CountType ones = ((frame >> bit) & 1) != 0
+                                     ? target.subtree_count -
+                                           target.bit_counts[bit]
+                                     : target.bit_counts[bit];
+          ancestor.bit_counts[bit] += target.subtree_count - 2 * ones;
+        }
+      }
+    }
+    pool_->nodes_[node_index].xor_tag ^= mask;
+    FlipBitCounts(node_index, mask);
+    extremes_valid_ = false;
+  }
+
+  // Applies XOR with `mask` lazily to the stored values in the closed range
+  // [lo, hi]. The range splits into O(kNumBits) aligned blocks, each a
+  // prefix subtree handled by XorPrefix, so a value never leaves its block.
+  // `mask` must therefore be below the size of the smallest block, which
+  // makes the update plain value ^ `mask` for the whole range; a wider mask
+  // asserts and leaves the trie unchanged. O(kNumBits^2), or O(kNumBits^3)
+  // with kTrackSums.
+  void XorRange(ValueType lo, ValueType hi, ValueType mask) {
+    assert((lo & ~BitMask()) == 0);
+    assert((hi & ~BitMask()) == 0);
+    mask &= BitMask();
+    if (hi < lo || mask == 0) {
+      return;
+    }
+    int min_block_bits = kNumBits;
+    for (ValueType block_lo = lo;;) {
+      const int block_bits = AlignedBlockBits(block_lo, hi);
+      min_block_bits = std::min(min_block_bits, block_bits);
+      const ValueType block_last = block_lo + LowBits(block_bits);
+      if (block_last == hi) {
+        break;
+      }
+      block_lo = block_last + 1;
+    }
+    assert(mask <= LowBits(min_block_bits) &&
+           "XorRange mask must fit in the smallest aligned block");
+    if (mask > LowBits(min_block_bits)) {
+      return;
+    }
+    while (true) {
+      const int block_bits = AlignedBlockBits(lo, hi);
+      XorPrefix(lo, kNumBits - block_bits, mask);
+      const ValueType block_last = lo + LowBits(block_bits);
+      if (block_last == hi) {
+        return;
+      }
+      lo = block_last + 1;
+    }
+  }
+
+  // Starts (or continues) recording every Insert, Erase, PopMin, PopMax,
+  // XorAll, XorPrefix and XorRange, and returns a checkpoint that Rollback
+  // can return to.
+  // Checkpoints nest in LIFO order. MergeFrom and Compact must not run while
+  // recording, and the pool must not be shared. O(1).
+  [[nodiscard]] Checkpoint MakeCheckpoint() {
+    assert(pool_.use_count() == 1);
+    recording_ = true;
+    return undo_log_.size();
+  }
+
+  // Undoes every recorded change made after `checkpoint`, newest first;
+  // later checkpoints become invalid. Recording continues. O(undone work).
+  void Rollback(Checkpoint checkpoint) {
+    assert(checkpoint <= undo_log_.size());
+    while (undo_log_.size() > checkpoint) {
+      const UndoEntry& entry = undo_log_.back();
+      switch (entry.kind) {
+        case UndoKind::kNode:
+          pool_->nodes_[entry.index] = entry.node;
+          break;
+        case UndoKind::kAppendNode:
+          pool_->nodes_.pop_back();
+          break;
+        case UndoKind::kFreeListPush:
+          pool_->free_list_.pop_back();
+          break;
+        case UndoKind::kFreeListPop:
+          pool_->free_list_.push_back(entry.index);
+          break;
+        case UndoKind::kMask:
+          xor_mask_ = entry.mask;
+          break;
+      }
+      undo_log_.pop_back();
+    }
+    RefreshExtremes();
+  }
+
+  // Stops recording and drops the undo log, invalidating all checkpoints.
+  void ClearCheckpoints() {
+    recording_ = false;
+    undo_log_.clear();
+  }
+
+  // Moves every value of `other` into this trie, leaving `other` empty. The
+  // tries may carry different XOR masks. Overlapping paths are combined node
+  // by node. When both tries share a NodePool, unmatched subtrees of `other`
+  // are relinked under a relative XOR tag and every combined node of `other`
+  // is released, so a call costs O(nodes combined) and merging the tries of
+  // a rooted tree bottom-up costs O(N * kNumBits) in total. Tries on
+  // separate pools copy the unmatched subtrees of the smaller pool into the
+  // larger one, which gives O(N * kNumBits * log N) small-to-large merging.
+  void MergeFrom(BinaryTrie&& other) {
+    assert(!recording_ && !other.recording_);
+    if (this == &other) {
+      return;
+    }
+    const bool shared_pool = pool_ == other.pool_;
+    if (!shared_pool && other.LiveNodeCount() > LiveNodeCount()) {
+      Swap(other);
+    }
+    if (other.TotalCount() > 0) {
+      MergeNodes(root_, other, other.root_, kNumBits - 1,
+                 xor_mask_ ^ other.xor_mask_);
+      if (shared_pool) {
+        // MergeNodes released the root of `other` into the pool.
+        other.root_ = kNull;
+      }
+    }
+    other = shared_pool ? BinaryTrie(pool_) : BinaryTrie();
+    RefreshExtremes();
+  }
+
+  // Rebuilds the node pool in DFS order without recycled slots and releases
+  // spare capacity. The pool must not be shared. O(number of live nodes).
+  void Compact() {
+    assert(!recording_);
+    assert(pool_.use_count() == 1);
+    struct Pending {
+      int old_index;
+      int parent;
+      int direction;
+    };
+    std::vector<Node> compacted;
+    compacted.reserve(pool_->nodes_.size() - pool_->free_list_.size());
+    std::vector<Pending> stack;
+    stack.push_back({root_, kNull, 0});
+    while (!stack.empty()) {
+      const Pending pending = stack.back();
+      stack.pop_back();
+      const int new_index = static_cast<int>(compacted.size());
+      compacted.push_back(pool_->nodes_[pending.old_index]);
+      if (pending.parent != kNull) {
+        compacted[pending.parent].children[pending.direction] = new_index;
+      }
+      for (int direction = 1; direction >= 0; --direction) {
+        const int child = pool_->nodes_[pending.old_index].children[direction];
+        if (child != kNull) {
+          stack.push_back({child, new_index, direction});
+        }
+      }
+    }
+    pool_->nodes_.swap(compacted);
+    pool_->free_list_.clear();
+    pool_->free_list_.shrink_to_fit();
+    root_ = 0;
+  }
+
+  // Iteration over (value, multiplicity) pairs in increasing value order.
+  [[nodiscard]] ConstIterator begin() const { return ConstIterator(this); }
+  [[nodiscard]] ConstIterator end() const { return ConstIterator(); }
+
+  // Heap bytes currently reserved by the node pool, free list and undo log;
+  // a shared pool is counted whole. O(1).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return pool_->nodes_.capacity() * sizeof(Node) +
+           pool_->free_list_.capacity() * sizeof(int) +
+           undo_log_.capacity() * sizeof(UndoEntry);
+  }
 
  private:
   static constexpr int kNull = -1;
+  // Independent descents interleaved by the *Batch queries.
+  static constexpr int kBatchLanes = 16;
+
+  struct NoBitCounts {};
 
   struct Node {
     std::array<int, 2> children{{kNull, kNull}};
     CountType subtree_count{0};
     CountType terminal_count{0};
+    // Leaves below with a positive terminal_count.
+    CountType distinct_count{0};
+    // Lazy XOR for the subtree, limited to the bits it branches on.
+    ValueType xor_tag{0};
+    // bit_counts[b]: values with bit b set, for the bits b the subtree
+    // decides, as seen from the parent (under every tag above this node but
+    // not its own). Higher bits follow from the path.
+    [[no_unique_address]] std::conditional_t<kTrackSums,
+                                             std::array<CountType, kNumBits>,
+                                             NoBitCounts> bit_counts{};
   };
 
   [[nodiscard]] static constexpr ValueType BitMask() {
@@ -254,183 +1006,769 @@ class BinaryTrie {
     }
   }
 
-  [[nodiscard]] ValueType ToStored(ValueType value) const {
-    return (value ^ xor_mask_) & BitMask();
+  // Bits strictly below `bit`.
+  [[nodiscard]] static constexpr ValueType LowBits(int bit) {
+    if (bit >= kNumBits) {
+      return BitMask();
+    }
+    return static_cast<ValueType>((ValueType{1} << bit) - ValueType{1});
   }
 
-  [[nodiscard]] ValueType ToActual(ValueType stored) const {
-    return (stored ^ xor_mask_) & BitMask();
+  // Bit size of the largest aligned block starting at `lo` that ends by
+  // `hi`, where lo <= hi.
+  [[nodiscard]] static int AlignedBlockBits(ValueType lo, ValueType hi) {
+    int block_bits =
+        lo == 0 ? kNumBits : std::min(std::countr_zero(lo), kNumBits);
+    while (hi - lo < LowBits(block_bits)) {
+      --block_bits;
+    }
+    return block_bits;
   }
 
   [[nodiscard]] CountType SubtreeCount(int node_index) const {
     return node_index == kNull ? static_cast<CountType>(0)
-                               : nodes_[node_index].subtree_count;
+                               : pool_->nodes_[node_index].subtree_count;
+  }
+
+  [[nodiscard]] CountType SubtreeDistinct(int node_index) const {
+    return node_index == kNull ? static_cast<CountType>(0)
+                               : pool_->nodes_[node_index].distinct_count;
   }
 
+  // Recomputes the cached Min and Max. O(kNumBits).
+  void RefreshExtremes() {
+    extremes_valid_ = true;
+    if (TotalCount() <= 0) {
+      return;
+    }
+    min_value_ = DescendToExtreme(root_, kNumBits - 1, 0, xor_mask_, false);
+    max_value_ = DescendToExtreme(root_, kNumBits - 1, 0, xor_mask_, true);
+  }
+
+  // Child of `node_index` holding `actual_bit` at `bit`, where `mask` is the
+  // XOR accumulated from the root down to and including `node_index`.
   [[nodiscard]] int ChildForActualBit(int node_index,
                                       int bit,
-                                      int actual_bit) const {
-    const int stored_bit =
-        actual_bit ^ static_cast<int>((xor_mask_ >> bit) & 1);
-    return nodes_[node_index].children[stored_bit];
+                                      int actual_bit,
+                                      ValueType mask) const {
+    const int stored_bit = actual_bit ^ static_cast<int>((mask >> bit) & 1);
+    return pool_->nodes_[node_index].children[stored_bit];
+  }
+
+  [[nodiscard]] int LiveNodeCount() const {
+    return static_cast<int>(pool_->nodes_.size() - pool_->free_list_.size());
+  }
+
+  void Swap(BinaryTrie& other) {
+    pool_.swap(other.pool_);
+    std::swap(root_, other.root_);
+    std::swap(xor_mask_, other.xor_mask_);
+    undo_log_.swap(other.undo_log_);
+    std::swap(recording_, other.recording_);
+    std::swap(min_value_, other.min_value_);
+    std::swap(max_value_, other.max_value_);
+    std::swap(extremes_valid_, other.extremes_valid_);
+  }
+
+  // Saves node `node_index` into the undo log before it is modified.
+  void LogNode(int node_index) {
+    if (recording_) {
+      undo_log_.push_back(
+          {UndoKind::kNode, node_index, pool_->nodes_[node_index],
+           ValueType{0}});
+    }
+  }
+
+  // Replaces the subtree's bit counts by those of its values XOR `mask`.
+  void FlipBitCounts(int node_index, ValueType mask) {
+    if constexpr (kTrackSums) {
+      Node& node = pool_->nodes_[node_index];
+      for (ValueType rest = mask; rest != 0; rest &= rest - 1) {
+        CountType& ones = node.bit_counts[std::countr_zero(rest)];
+        ones = node.subtree_count - ones;
+      }
+    }
+  }
+
+  // Applies the tag of `node_index`, which branches on `bit`: swaps the
+  // children when the tag covers `bit` and hands lower bits to them.
+  void PushDown(int node_index, int bit) {
+    const ValueType tag = pool_->nodes_[node_index].xor_tag;
+    if (tag == 0) {
+      return;
+    }
+    pool_->nodes_[node_index].xor_tag = 0;
+    auto& children = pool_->nodes_[node_index].children;
+    if (((tag >> bit) & 1) != 0) {
+      std::swap(children[0], children[1]);
+    }
+    for (const int child : children) {
+      if (child != kNull) {
+        pool_->nodes_[child].xor_tag ^= tag & LowBits(bit);
+        FlipBitCounts(child, tag & LowBits(bit));
+      }
+    }
   }
 
-  bool FindLowerBound(int node_index,
-                      int bit,
-                      ValueType target,
-                      ValueType prefix_actual,
-                      bool tight,
-                      ValueType* result) const {
-    if (node_index == kNull || SubtreeCount(node_index) <= 0) {
-      return false;
+  // Adds `other`'s subtree at `src` into `dst`; both branch on `bit` and have
+  // every tag above them pushed, so `relative_mask` (the difference of the
+  // two global masks) maps `other`'s directions onto ours. On a shared pool
+  // the unmatched children of `src` are relinked and `src` is released.
+  void MergeNodes(int dst,
+                  BinaryTrie& other,
+                  int src,
+                  int bit,
+                  ValueType relative_mask) {
+    if (bit >= 0) {
+      PushDown(dst, bit);
+      other.PushDown(src, bit);
     }
+    const Node& source = other.pool_->nodes_[src];
+    pool_->nodes_[dst].subtree_count += source.subtree_count;
+    pool_->nodes_[dst].terminal_count += source.terminal_count;
+    if constexpr (kTrackSums) {
+      for (int b = 0; b <= bit; ++b) {
+        pool_->nodes_[dst].bit_counts[b] +=
+            ((relative_mask >> b) & 1) != 0
+                ? source.subtree_count - source.bit_counts[b]
+                : source.bit_counts[b];
+      }
+    }
+    const bool shared_pool = pool_ == other.pool_;
     if (bit < 0) {
-      if (nodes_[node_index].terminal_count > 0) {
-        *result = prefix_actual;
-        return true;
-      }
-      return false;
-    }
-    const int target_bit = static_cast<int>((target >> bit) & 1);
-    if (tight) {
-      const int child_same = ChildForActualBit(node_index, bit, target_bit);
-      if (child_same != kNull &&
-          FindLowerBound(
-              child_same,
-              bit - 1,
-              target,
-              static_cast<ValueType>(
-                  prefix_actual | (static_cast<ValueType>(target_bit) << bit)),
-              true,
-              result)) {
-        return true;
-      }
-      if (target_bit == 0) {
-        const int child_one = ChildForActualBit(node_index, bit, 1);
-        if (child_one != kNull &&
-            FindLowerBound(
-                child_one,
-                bit - 1,
-                target,
-                static_cast<ValueType>(prefix_actual | (ValueType{1} << bit)),
-                false,
-                result)) {
-          return true;
+      Node& leaf = pool_->nodes_[dst];
+      leaf.distinct_count = leaf.terminal_count > 0 ? 1 : 0;
+      if (shared_pool) {
+        pool_->free_list_.push_back(src);
+      }
+      return;
+    }
+    const int relative_bit = static_cast<int>((relative_mask >> bit) & 1);
+    for (int direction = 0; direction < 2; ++direction) {
+      const int src_child =
+          other.pool_->nodes_[src].children[direction ^ relative_bit];
+      if (src_child == kNull) {
+        continue;
+      }
+      const int dst_child = pool_->nodes_[dst].children[direction];
+      if (dst_child == kNull && shared_pool) {
+        pool_->nodes_[src_child].xor_tag ^= relative_mask & LowBits(bit);
+        FlipBitCounts(src_child, relative_mask & LowBits(bit));
+        pool_->nodes_[dst].children[direction] = src_child;
+      } else if (dst_child == kNull) {
+        const int copied = CopySubtree(other, src_child, bit, relative_mask);
+        pool_->nodes_[dst].children[direction] = copied;
+      } else {
+        MergeNodes(dst_child, other, src_child, bit - 1, relative_mask);
+      }
+    }
+    Node& merged = pool_->nodes_[dst];
+    merged.distinct_count = SubtreeDistinct(merged.children[0]) +
+                            SubtreeDistinct(merged.children[1]);
+    if (shared_pool) {
+      pool_->free_list_.push_back(src);
+    }
+  }
+
+  // Returns `root` and every node below it to the pool's free list.
+  void ReleaseSubtree(int root) {
+    std::vector<int> stack = {root};
+    while (!stack.empty()) {
+      const int node_index = stack.back();
+      stack.pop_back();
+      for (const int child : pool_->nodes_[node_index].children) {
+        if (child != kNull) {
+          stack.push_back(child);
+        }
+      }
+      pool_->free_list_.push_back(node_index);
+    }
+  }
+
+  // Copies `other`'s subtree at `src_root`, a child of a node branching on
+  // `parent_bit`, into this pool; `relative_mask` becomes a tag on the copy.
+  int CopySubtree(const BinaryTrie& other,
+                  int src_root,
+                  int parent_bit,
+                  ValueType relative_mask) {
+    struct Pending {
+      int source;
+      int parent;
+      int direction;
+    };
+    const int root = NewNode();
+    pool_->nodes_[root] = other.pool_->nodes_[src_root];
+    pool_->nodes_[root].xor_tag ^= relative_mask & LowBits(parent_bit);
+    FlipBitCounts(root, relative_mask & LowBits(parent_bit));
+    std::vector<Pending> stack;
+    for (int direction = 0; direction < 2; ++direction) {
+      const int child = other.pool_->nodes_[src_root].children[direction];
+      if (child != kNull) {
+        stack.push_back({child, root, direction});
+      }
+    }
+    while (!stack.empty()) {
+      const Pending pending = stack.back();
+      stack.pop_back();
+      const int copied = NewNode();
+      pool_->nodes_[copied] = other.pool_->nodes_[pending.source];
+      pool_->nodes_[pending.parent].children[pending.direction] = copied;
+      for (int direction = 0; direction < 2; ++direction) {
+        const int child =
+            other.pool_->nodes_[pending.source].children[direction];
+        if (child != kNull) {
+          stack.push_back({child, copied, direction});
         }
       }
-      return false;
     }
-    for (int actual_bit = 0; actual_bit <= 1; ++actual_bit) {
-      const int child = ChildForActualBit(node_index, bit, actual_bit);
-      if (child != kNull &&
-          FindLowerBound(
-              child,
-              bit - 1,
-              target,
-              static_cast<ValueType>(
-                  prefix_actual | (static_cast<ValueType>(actual_bit) << bit)),
-              false,
-              result)) {
-        return true;
+    return root;
+  }
+
+  void AddBitCounts(int node_index, ValueType stored_value, CountType count) {
+    if constexpr (kTrackSums) {
+      auto& bit_counts = pool_->nodes_[node_index].bit_counts;
+      for (ValueType rest = stored_value; rest != 0; rest &= rest - 1) {
+        bit_counts[std::countr_zero(rest)] += count;
       }
     }
-    return false;
   }
 
-  bool FindPrev(int node_index,
-                int bit,
-                ValueType target,
-                ValueType prefix_actual,
-                bool tight,
-                ValueType* result) const {
-    if (node_index == kNull || SubtreeCount(node_index) <= 0) {
-      return false;
+  // Sum of the subtree's values, where `mask` is the XOR accumulated down to
+  // and including its parent, the subtree decides bits [0, level) and
+  // `prefix_actual` holds the shared higher bits.
+  template <typename SumType>
+  [[nodiscard]] SumType SubtreeSum(int node_index,
+                                   ValueType mask,
+                                   ValueType prefix_actual,
+                                   int level) const {
+    if (node_index == kNull) {
+      return SumType{0};
     }
-    if (bit < 0) {
-      if (nodes_[node_index].terminal_count > 0) {
-        *result = prefix_actual;
-        return true;
-      }
-      return false;
-    }
-    const int target_bit = static_cast<int>((target >> bit) & 1);
-    if (tight) {
-      const int child_same = ChildForActualBit(node_index, bit, target_bit);
-      if (child_same != kNull &&
-          FindPrev(
-              child_same,
-              bit - 1,
-              target,
-              static_cast<ValueType>(
-                  prefix_actual | (static_cast<ValueType>(target_bit) << bit)),
-              true,
-              result)) {
-        return true;
-      }
-      if (target_bit == 1) {
-        const int child_zero = ChildForActualBit(node_index, bit, 0);
-        if (child_zero != kNull &&
-            FindPrev(
-                child_zero, bit - 1, target, prefix_actual, false, result)) {
-          return true;
+    const Node& node = pool_->nodes_[node_index];
+    SumType sum = static_cast<SumType>(prefix_actual) *
+                  static_cast<SumType>(node.subtree_count);
+    for (int bit = 0; bit < level; ++bit) {
+      const CountType ones = ((mask >> bit) & 1) != 0
+                                 ? node.subtree_count - node.bit_counts[bit]
+                                 : node.bit_counts[bit];
+      sum += static_cast<SumType>(ones) << bit;
+    }
+    return sum;
+  }
+
+  // A node together with the XOR accumulated down to and including it.
+  struct PairCursor {
+    int node_index;
+    ValueType mask;
+  };
+
+  // Child of `cursor`, which branches on `bit`, holding `actual_bit` there.
+  [[nodiscard]] PairCursor ChildCursor(const PairCursor& cursor,
+                                       int bit,
+                                       int actual_bit) const {
+    if (cursor.node_index == kNull) {
+      return {kNull, 0};
+    }
+    const int child =
+        ChildForActualBit(cursor.node_index, bit, actual_bit, cursor.mask);
+    if (child == kNull) {
+      return {kNull, 0};
+    }
+    return {child, static_cast<ValueType>(cursor.mask ^
+                                          pool_->nodes_[child].xor_tag)};
+  }
+
+  template <typename SumType>
+  [[nodiscard]] static SumType Pairs(CountType count) {
+    const auto n = static_cast<SumType>(count);
+    return n * (n - 1) / 2;
+  }
+
+  // Pairs between two disjoint subtrees.
+  template <typename SumType>
+  [[nodiscard]] SumType CrossPairs(const PairCursor& a,
+                                   const PairCursor& b) const {
+    return static_cast<SumType>(SubtreeCount(a.node_index)) *
+           static_cast<SumType>(SubtreeCount(b.node_index));
+  }
+
+  // Pairs across the subtrees of `a` and `b`, or within one subtree when they
+  // coincide, whose XOR on bits [0, bit] is <= those bits of `limit`. Both
+  // subtrees branch on `bit`.
+  template <typename SumType>
+  [[nodiscard]] SumType CountPairsXorAtMost(const PairCursor& a,
+                                            const PairCursor& b,
+                                            int bit,
+                                            ValueType limit) const {
+    if (a.node_index == kNull || b.node_index == kNull) {
+      return SumType{0};
+    }
+    const bool self = a.node_index == b.node_index;
+    const SumType all = self ? Pairs<SumType>(SubtreeCount(a.node_index))
+                             : CrossPairs<SumType>(a, b);
+    if (all == 0 || bit < 0 ||
+        (limit & LowBits(bit + 1)) == LowBits(bit + 1)) {
+      return all;
+    }
+    const PairCursor a0 = ChildCursor(a, bit, 0);
+    const PairCursor a1 = ChildCursor(a, bit, 1);
+    if (self) {
+      if (((limit >> bit) & 1) == 0) {
+        return CountPairsXorAtMost<SumType>(a0, a0, bit - 1, limit) +
+               CountPairsXorAtMost<SumType>(a1, a1, bit - 1, limit);
+      }
+      return Pairs<SumType>(SubtreeCount(a0.node_index)) +
+             Pairs<SumType>(SubtreeCount(a1.node_index)) +
+             CountPairsXorAtMost<SumType>(a0, a1, bit - 1, limit);
+    }
+    const PairCursor b0 = ChildCursor(b, bit, 0);
+    const PairCursor b1 = ChildCursor(b, bit, 1);
+    if (((limit >> bit) & 1) == 0) {
+      return CountPairsXorAtMost<SumType>(a0, b0, bit - 1, limit) +
+             CountPairsXorAtMost<SumType>(a1, b1, bit - 1, limit);
+    }
+    return CrossPairs<SumType>(a0, b0) + CrossPairs<SumType>(a1, b1) +
+           CountPairsXorAtMost<SumType>(a0, b1, bit - 1, limit) +
+           CountPairsXorAtMost<SumType>(a1, b0, bit - 1, limit);
+  }
+
+  // Counts the values of the subtree at `node_index`, which decides bits
+  // [0, top_bit] and sees `parent_mask` from above, that are >= `bound`
+  // (`upward`) or <= `bound` on those bits.
+  [[nodiscard]] CountType CountTowardSide(int node_index,
+                                          int top_bit,
+                                          ValueType bound,
+                                          ValueType parent_mask,
+                                          bool upward) const {
+    if (node_index == kNull) {
+      return static_cast<CountType>(0);
+    }
+    const int toward = static_cast<int>(upward);
+    ValueType mask = parent_mask ^ pool_->nodes_[node_index].xor_tag;
+    CountType result = 0;
+    for (int bit = top_bit; bit >= 0; --bit) {
+      const int bound_bit = static_cast<int>((bound >> bit) & 1);
+      if (bound_bit != toward) {
+        result +=
+            SubtreeCount(ChildForActualBit(node_index, bit, toward, mask));
+      }
+      node_index = ChildForActualBit(node_index, bit, bound_bit, mask);
+      if (node_index == kNull) {
+        return result;
+      }
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    return result + pool_->nodes_[node_index].terminal_count;
+  }
+
+  // CountLess over the stored values viewed through `mask`.
+  [[nodiscard]] CountType CountLessUnderMask(ValueType value,
+                                             ValueType mask) const {
+    CountType result = 0;
+    int node_index = root_;
+    for (int bit = kNumBits - 1; bit >= 0 && node_index != kNull; --bit) {
+      const int mask_bit = static_cast<int>((mask >> bit) & 1);
+      const int zero_child = pool_->nodes_[node_index].children[mask_bit];
+      const int one_child = pool_->nodes_[node_index].children[mask_bit ^ 1];
+      const int actual_bit = static_cast<int>((value >> bit) & 1);
+      if (actual_bit == 1) {
+        result += SubtreeCount(zero_child);
+        node_index = one_child;
+      } else {
+        node_index = zero_child;
+      }
+      if (node_index != kNull) {
+        mask ^= pool_->nodes_[node_index].xor_tag;
+      }
+    }
+    return result;
+  }
+
+  // Kth over the stored values viewed through `mask`.
+  [[nodiscard]] std::optional<ValueType> KthUnderMask(CountType k,
+                                                      ValueType mask) const {
+    if (k < 0) {
+      return std::nullopt;
+    }
+    const CountType total = TotalCount();
+    if (total <= 0) {
+      return std::nullopt;
+    }
+    using UnsignedCount = std::make_unsigned_t<CountType>;
+    const auto target = static_cast<UnsignedCount>(k);
+    const auto total_unsigned = static_cast<UnsignedCount>(total);
+    if (target >= total_unsigned) {
+      return std::nullopt;
+    }
+    int node_index = root_;
+    ValueType actual_value = 0;
+    UnsignedCount remaining = target;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int mask_bit = static_cast<int>((mask >> bit) & 1);
+      const int zero_child = pool_->nodes_[node_index].children[mask_bit];
+      const auto zero_count =
+          static_cast<UnsignedCount>(SubtreeCount(zero_child));
+      if (remaining < zero_count) {
+        node_index = zero_child;
+      } else {
+        remaining -= zero_count;
+        const int one_child = pool_->nodes_[node_index].children[mask_bit ^ 1];
+        if (one_child == kNull || SubtreeCount(one_child) <= 0) {
+          return std::nullopt;
         }
+        node_index = one_child;
+        actual_value |= (ValueType{1} << bit);
       }
-      return false;
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
-    for (int actual_bit = 1; actual_bit >= 0; --actual_bit) {
-      const int child = ChildForActualBit(node_index, bit, actual_bit);
-      if (child != kNull &&
-          FindPrev(
-              child,
-              bit - 1,
-              target,
-              static_cast<ValueType>(
-                  prefix_actual | (static_cast<ValueType>(actual_bit) << bit)),
-              false,
-              result)) {
-        return true;
+    return actual_value;
+  }
+
+  // Walks down along `value` once, remembering the deepest branch point where
+  // a sibling subtree lies on the requested side, then jumps there and
+  // descends to its extreme. `upward` selects the successor side and
+  // `inclusive` accepts `value` itself.
+  [[nodiscard]] std::optional<ValueType> FindNeighbor(ValueType value,
+                                                      bool upward,
+                                                      bool inclusive) const {
+    assert((value & ~BitMask()) == 0);
+    if (TotalCount() <= 0) {
+      return std::nullopt;
+    }
+    const int toward = static_cast<int>(upward);
+    ValueType mask = xor_mask_;
+    int node_index = root_;
+    int branch_node = kNull;
+    int branch_bit = -1;
+    ValueType branch_mask = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int actual_bit = static_cast<int>((value >> bit) & 1);
+      if (actual_bit != toward) {
+        const int sibling = ChildForActualBit(node_index, bit, toward, mask);
+        if (SubtreeCount(sibling) > 0) {
+          branch_node = sibling;
+          branch_bit = bit;
+          branch_mask = mask ^ pool_->nodes_[sibling].xor_tag;
+        }
       }
+      const int child = ChildForActualBit(node_index, bit, actual_bit, mask);
+      if (SubtreeCount(child) <= 0) {
+        node_index = kNull;
+        break;
+      }
+      node_index = child;
+      mask ^= pool_->nodes_[node_index].xor_tag;
     }
-    return false;
+    if (inclusive && node_index != kNull) {
+      return value;
+    }
+    if (branch_node == kNull) {
+      return std::nullopt;
+    }
+    ValueType prefix = HighBits(value, branch_bit + 1);
+    if (upward) {
+      prefix |= (ValueType{1} << branch_bit);
+    }
+    return DescendToExtreme(
+        branch_node, branch_bit - 1, prefix, branch_mask, !upward);
   }
 
-  bool FindExtremeXor(ValueType value,
-                      bool maximize,
-                      ValueType* stored_value) const {
+  // Follows the smallest (or largest when `maximize`) non-empty branch from
+  // `node_index`, whose subtree decides bits [0, top_bit] and sees the
+  // accumulated XOR `mask`, and returns the reached value with
+  // `prefix_actual` supplying the higher bits.
+  [[nodiscard]] ValueType DescendToExtreme(int node_index,
+                                           int top_bit,
+                                           ValueType prefix_actual,
+                                           ValueType mask,
+                                           bool maximize) const {
+    const int preferred_bit = static_cast<int>(maximize);
+    for (int bit = top_bit; bit >= 0; --bit) {
+      int actual_bit = preferred_bit;
+      int child = ChildForActualBit(node_index, bit, actual_bit, mask);
+      if (SubtreeCount(child) <= 0) {
+        actual_bit ^= 1;
+        child = ChildForActualBit(node_index, bit, actual_bit, mask);
+      }
+      if (actual_bit == 1) {
+        prefix_actual |= (ValueType{1} << bit);
+      }
+      node_index = child;
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    return prefix_actual;
+  }
+
+  // Keeps the bits of `value` at positions >= `low_bit`.
+  [[nodiscard]] static constexpr ValueType HighBits(ValueType value,
+                                                    int low_bit) {
+    if (low_bit >= kNumBits) {
+      return 0;
+    }
+    return static_cast<ValueType>((value >> low_bit) << low_bit);
+  }
+
+  // Returns (best element XOR `value`) for the largest or smallest XOR.
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(ValueType value,
+                                                        bool maximize) const {
     if (TotalCount() <= 0) {
-      return false;
+      return std::nullopt;
     }
-    const ValueType mask = BitMask();
-    ValueType key = (value ^ xor_mask_) & mask;
-    int node_index = 0;
+    ValueType mask = xor_mask_;
+    int node_index = root_;
     ValueType result = 0;
     for (int bit = kNumBits - 1; bit >= 0; --bit) {
       int desired =
-          static_cast<int>(((key >> bit) & 1) ^ static_cast<int>(maximize));
-      int child = nodes_[node_index].children[desired];
-      if (child == kNull || SubtreeCount(child) <= 0) {
+          static_cast<int>((value >> bit) & 1) ^ static_cast<int>(maximize);
+      int child = ChildForActualBit(node_index, bit, desired, mask);
+      if (SubtreeCount(child) <= 0) {
         desired ^= 1;
-        child = nodes_[node_index].children[desired];
-        if (child == kNull || SubtreeCount(child) <= 0) {
-          return false;
-        }
+        child = ChildForActualBit(node_index, bit, desired, mask);
       }
       if (desired == 1) {
         result |= (ValueType{1} << bit);
       }
       node_index = child;
+      mask ^= pool_->nodes_[node_index].xor_tag;
+    }
+    return (result ^ value) & BitMask();
+  }
+
+  // Batched FindExtremeXor. Every linked child is non-empty (Erase unlinks
+  // emptied nodes), so a lane picks its direction from the current node
+  // alone and never touches a sibling.
+  [[nodiscard]] std::vector<std::optional<ValueType>> FindExtremeXorBatch(
+      const std::vector<ValueType>& values,
+      bool maximize) const {
+    std::vector<std::optional<ValueType>> answers(values.size());
+    if (TotalCount() <= 0) {
+      return answers;
+    }
+    for (std::size_t begin = 0; begin < values.size(); begin += kBatchLanes) {
+      const int lanes = static_cast<int>(
+          std::min<std::size_t>(kBatchLanes, values.size() - begin));
+      std::array<int, kBatchLanes> node_indices;
+      std::array<ValueType, kBatchLanes> masks;
+      std::array<ValueType, kBatchLanes> results;
+      node_indices.fill(root_);
+      masks.fill(xor_mask_);
+      results.fill(0);
+      for (int bit = kNumBits - 1; bit >= 0; --bit) {
+        for (int lane = 0; lane < lanes; ++lane) {
+          const ValueType value = values[begin + lane];
+          assert((value & ~BitMask()) == 0);
+          const Node& node = pool_->nodes_[node_indices[lane]];
+          masks[lane] ^= node.xor_tag;
+          const int mask_bit = static_cast<int>((masks[lane] >> bit) & 1);
+          int desired = static_cast<int>((value >> bit) & 1) ^
+                        static_cast<int>(maximize);
+          int child = node.children[desired ^ mask_bit];
+          if (child == kNull) {
+            desired ^= 1;
+            child = node.children[desired ^ mask_bit];
+          }
+          if (desired == 1) {
+            results[lane] |= (ValueType{1} << bit);
+          }
+          node_indices[lane] = child;
+          Prefetch(child);
+        }
+      }
+      for (int lane = 0; lane < lanes; ++lane) {
+        answers[begin + lane] =
+            (results[lane] ^ values[begin + lane]) & BitMask();
+      }
+    }
+    return answers;
+  }
+
+  void Prefetch(int node_index) const {
+#if defined(__GNUC__) || defined(__clang__)
+    if (node_index != kNull) {
+      __builtin_prefetch(&pool_->nodes_[node_index]);
+    }
+#else
+    static_cast<void>(node_index);
+#endif
+  }
+
+  // Unlinks the topmost emptied node on `path` (a root-to-leaf walk whose
+  // per-node views pick the directions) and recycles it together with its
+  // emptied descendants.
+  void ReclaimEmptyPath(const std::array<int, kNumBits + 1>& path,
+                        const std::array<ValueType, kNumBits + 1>& views) {
+    int depth = 1;
+    while (depth <= kNumBits && pool_->nodes_[path[depth]].subtree_count > 0) {
+      ++depth;
+    }
+    if (depth > kNumBits) {
+      return;
+    }
+    const int bit = kNumBits - depth;
+    const int direction = static_cast<int>((views[depth] >> bit) & 1);
+    pool_->nodes_[path[depth - 1]].children[direction] = kNull;
+    for (; depth <= kNumBits; ++depth) {
+      pool_->free_list_.push_back(path[depth]);
+      if (recording_) {
+        undo_log_.push_back(
+            {UndoKind::kFreeListPush, path[depth], Node{}, ValueType{0}});
+      }
+    }
+  }
+
+  // LSD radix sort on 8-bit digits; digits shared by every value are
+  // skipped.
+  static void RadixSort(std::vector<ValueType>& values) {
+    constexpr int kDigitBits = 8;
+    constexpr std::size_t kBuckets = std::size_t{1} << kDigitBits;
+    std::vector<ValueType> buffer(values.size());
+    for (int shift = 0; shift < kNumBits; shift += kDigitBits) {
+      std::array<std::size_t, kBuckets> offsets{};
+      for (const ValueType value : values) {
+        ++offsets[(value >> shift) & (kBuckets - 1)];
+      }
+      if (std::ranges::find(offsets, values.size()) != offsets.end()) {
+        continue;
+      }
+      std::size_t total = 0;
+      for (std::size_t& offset : offsets) {
+        total += std::exchange(offset, total);
+      }
+      for (const ValueType value : values) {
+        buffer[offsets[(value >> shift) & (kBuckets - 1)]++] = value;
+      }
+      values.swap(buffer);
+    }
+  }
+
+  // Appends the sorted `values` to an empty trie. Keeps the current
+  // root-to-leaf path open and folds each node's counts into its parent when
+  // the walk leaves it, so every node is written once.
+  void BuildFromSorted(const std::vector<ValueType>& values) {
+    assert(LiveNodeCount() == 1 && TotalCount() == 0);
+    std::array<int, kNumBits + 1> path{};
+    path[0] = root_;
+    int open_depth = 0;
+    for (std::size_t i = 0; i < values.size();) {
+      const ValueType value = values[i];
+      assert((value & ~BitMask()) == 0);
+      std::size_t next = i + 1;
+      while (next < values.size() && values[next] == value) {
+        ++next;
+      }
+      if (i > 0) {
+        const int shared_depth =
+            kNumBits - static_cast<int>(std::bit_width(
+                           static_cast<ValueType>(values[i - 1] ^ value)));
+        CloseBuildPath(path, open_depth, shared_depth);
+        open_depth = shared_depth;
+      }
+      for (int depth = open_depth + 1; depth <= kNumBits; ++depth) {
+        const int direction =
+            static_cast<int>((value >> (kNumBits - depth)) & 1);
+        const int child_index = NewNode();
+        pool_->nodes_[path[depth - 1]].children[direction] = child_index;
+        path[depth] = child_index;
+      }
+      open_depth = kNumBits;
+      Node& leaf = pool_->nodes_[path[kNumBits]];
+      leaf.terminal_count = static_cast<CountType>(next - i);
+      leaf.subtree_count = leaf.terminal_count;
+      leaf.distinct_count = 1;
+      i = next;
+    }
+    if (!values.empty()) {
+      CloseBuildPath(path, open_depth, 0);
+    }
+  }
+
+  // Folds the counts of path[from_depth] .. path[to_depth + 1] upwards.
+  void CloseBuildPath(const std::array<int, kNumBits + 1>& path,
+                      int from_depth,
+                      int to_depth) {
+    for (int depth = from_depth; depth > to_depth; --depth) {
+      const Node& child = pool_->nodes_[path[depth]];
+      Node& parent = pool_->nodes_[path[depth - 1]];
+      parent.subtree_count += child.subtree_count;
+      parent.distinct_count += child.distinct_count;
+      if constexpr (kTrackSums) {
+        const int level = kNumBits - depth;
+        for (int bit = 0; bit < level; ++bit) {
+          parent.bit_counts[bit] += child.bit_counts[bit];
+        }
+        if (parent.children[1] == path[depth]) {
+          parent.bit_counts[level] += child.subtree_count;
+        }
+      }
     }
-    *stored_value = result;
-    return true;
   }
 
   int NewNode() {
-    nodes_.emplace_back();
-    return static_cast<int>(nodes_.size() - 1);
+    if (!pool_->free_list_.empty()) {
+      const int idx = pool_->free_list_.back();
+      pool_->free_list_.pop_back();
+      if (recording_) {
+        undo_log_.push_back(
+            {UndoKind::kFreeListPop, idx, Node{}, ValueType{0}});
+      }
+      LogNode(idx);
+      pool_->nodes_[idx] = Node{};
+      return idx;
+    }
+    if (recording_) {
+      undo_log_.push_back(
+          {UndoKind::kAppendNode, kNull, Node{}, ValueType{0}});
+    }
+    pool_->nodes_.emplace_back();
+    return static_cast<int>(pool_->nodes_.size() - 1);
   }
 
-  std::vector<Node> nodes_;
+  enum class UndoKind : unsigned char {
+    kNode,
+    kAppendNode,
+    kFreeListPush,
+    kFreeListPop,
+    kMask,
+  };
+
+  // One reversible change: a node overwritten (`node` holds its old value),
+  // a node appended, a free-list push or pop of `index`, or an XorAll
+  // (`mask` holds the old global mask).
+  struct UndoEntry {
+    UndoKind kind;
+    int index;
+    Node node;
+    ValueType mask;
+  };
+
+  std::shared_ptr<NodePool> pool_;
+  int root_ = kNull;
   ValueType xor_mask_{0};
+  std::vector<UndoEntry> undo_log_;
+  bool recording_ = false;
+  // Cached Min and Max, meaningful while extremes_valid_ and non-empty. XOR
+  // updates only invalidate them; the next Insert or Erase recomputes.
+  ValueType min_value_{0};
+  ValueType max_value_{0};
+  bool extremes_valid_ = true;
+};
+
+template <std::unsigned_integral ValueType,
+          int kNumBits,
+          std::integral CountType,
+          bool kTrackSums>
+class BinaryTrie<ValueType, kNumBits, CountType, kTrackSums>::NodePool {
+ public:
+  NodePool() = default;
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+ private:
+  friend class BinaryTrie;
+
+  std::vector<Node> nodes_;
+  std::vector<int> free_list_;
 };
 
 }  // namespace hotaosa
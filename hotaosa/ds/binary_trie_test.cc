@@ -1,6 +1,13 @@
 #include "hotaosa/ds/binary_trie.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -66,6 +73,33 @@ TEST(BinaryTrieTest, CountLessAndGreater) {
   EXPECT_EQ(trie.CountGreater(2), 3);
 }
 
+TEST(BinaryTrieTest, RankAndCountInRange) {
+  BinaryTrie<std::uint16_t, 8> trie;
+  trie.Insert(1);
+  trie.Insert(3, 2);
+  trie.Insert(7);
+  trie.Insert(200);
+
+  const auto rank = trie.Rank(3);
+  EXPECT_EQ(rank.less, 1);
+  EXPECT_EQ(rank.equal, 2);
+  EXPECT_EQ(rank.greater, 2);
+  const auto missing = trie.Rank(5);
+  EXPECT_EQ(missing.less, 3);
+  EXPECT_EQ(missing.equal, 0);
+  EXPECT_EQ(missing.greater, 2);
+
+  EXPECT_EQ(trie.CountInRange(0, 255), 5);
+  EXPECT_EQ(trie.CountInRange(3, 3), 2);
+  EXPECT_EQ(trie.CountInRange(2, 7), 3);
+  EXPECT_EQ(trie.CountInRange(8, 199), 0);
+  EXPECT_EQ(trie.CountInRange(7, 1), 0);
+
+  trie.XorAll(0x0F);  // {14, 12, 12, 8, 199}
+  EXPECT_EQ(trie.CountInRange(8, 12), 3);
+  EXPECT_EQ(trie.Rank(12).greater, 2);
+}
+
 TEST(BinaryTrieTest, LowerBoundAndPrev) {
   BinaryTrie<std::uint16_t, 10> trie;
   trie.Insert(12);
@@ -89,6 +123,80 @@ TEST(BinaryTrieTest, LowerBoundAndPrev) {
   EXPECT_FALSE(trie.Prev(5).has_value());
 }
 
+TEST(BinaryTrieTest, SuccessorFamilyWithXorMask) {
+  BinaryTrie<std::uint16_t, 8> trie;
+  trie.Insert(3);
+  trie.Insert(9);
+  trie.Insert(9);
+  trie.Insert(200);
+
+  ASSERT_TRUE(trie.UpperBound(3).has_value());
+  EXPECT_EQ(trie.UpperBound(3).value(), 9);
+  ASSERT_TRUE(trie.Next(9).has_value());
+  EXPECT_EQ(trie.Next(9).value(), 200);
+  EXPECT_FALSE(trie.Next(200).has_value());
+  ASSERT_TRUE(trie.LowerBound(10).has_value());
+  EXPECT_EQ(trie.LowerBound(10).value(), 200);
+  ASSERT_TRUE(trie.Prev(199).has_value());
+  EXPECT_EQ(trie.Prev(199).value(), 9);
+  EXPECT_FALSE(trie.Prev(2).has_value());
+
+  trie.XorAll(0xFF);  // {3,9,9,200} -> {252,246,246,55}
+  ASSERT_TRUE(trie.Min().has_value());
+  EXPECT_EQ(trie.Min().value(), 55);
+  ASSERT_TRUE(trie.Max().has_value());
+  EXPECT_EQ(trie.Max().value(), 252);
+  ASSERT_TRUE(trie.UpperBound(55).has_value());
+  EXPECT_EQ(trie.UpperBound(55).value(), 246);
+  ASSERT_TRUE(trie.Prev(250).has_value());
+  EXPECT_EQ(trie.Prev(250).value(), 246);
+  ASSERT_TRUE(trie.LowerBound(247).has_value());
+  EXPECT_EQ(trie.LowerBound(247).value(), 252);
+}
+
+TEST(BinaryTrieTest, PopMinAndPopMax) {
+  BinaryTrie<std::uint32_t, 12> trie;
+  EXPECT_FALSE(trie.Min().has_value());
+  EXPECT_FALSE(trie.PopMax().has_value());
+
+  trie.Insert(7, 2);
+  trie.Insert(1);
+  trie.Insert(4000);
+
+  EXPECT_EQ(trie.PopMin(), std::optional<std::uint32_t>(1));
+  EXPECT_EQ(trie.PopMax(), std::optional<std::uint32_t>(4000));
+  EXPECT_EQ(trie.PopMax(), std::optional<std::uint32_t>(7));
+  EXPECT_EQ(trie.TotalCount(), 1);
+  EXPECT_EQ(trie.PopMin(), std::optional<std::uint32_t>(7));
+  EXPECT_FALSE(trie.PopMin().has_value());
+}
+
+TEST(BinaryTrieTest, EraseRecyclesNodesUnderChurn) {
+  BinaryTrie<std::uint32_t> trie;
+  for (std::uint32_t value = 0; value < 64; ++value) {
+    trie.Insert(value * 2654435761u);
+  }
+  const std::size_t steady_usage = trie.MemoryUsage();
+  for (std::uint32_t round = 1; round <= 1000; ++round) {
+    trie.Erase((round - 1) * 2654435761u);
+    trie.Insert((round + 63) * 2654435761u);
+  }
+  EXPECT_EQ(trie.TotalCount(), 64);
+  EXPECT_LE(trie.MemoryUsage(), 2 * steady_usage);
+
+  trie.Compact();
+  EXPECT_EQ(trie.TotalCount(), 64);
+  EXPECT_TRUE(trie.Contains(1000 * 2654435761u));
+  EXPECT_FALSE(trie.Contains(999 * 2654435761u));
+  EXPECT_EQ(trie.Kth(0), trie.Min());
+
+  for (std::uint32_t round = 1000; round < 1064; ++round) {
+    trie.Erase(round * 2654435761u);
+  }
+  EXPECT_EQ(trie.TotalCount(), 0);
+  EXPECT_FALSE(trie.Min().has_value());
+}
+
 TEST(BinaryTrieTest, MaxMinXorQueries) {
   BinaryTrie<std::uint32_t> trie;
   trie.Insert(1);
@@ -102,6 +210,134 @@ TEST(BinaryTrieTest, MaxMinXorQueries) {
   EXPECT_EQ(trie.MinXor(6).value(), 6 ^ 4);  // best element is 4 -> xor = 2
 }
 
+TEST(BinaryTrieTest, SumQueriesFollowXorAll) {
+  BinaryTrie<std::uint32_t, 8, int, /*kTrackSums=*/true> trie;
+  trie.Insert(3);
+  trie.Insert(10, 2);
+  trie.Insert(200);
+
+  EXPECT_EQ(trie.SumOfSmallest(0), 0);
+  EXPECT_EQ(trie.SumOfSmallest(2), 3 + 10);
+  EXPECT_EQ(trie.SumOfSmallest(3), 3 + 10 + 10);
+  EXPECT_EQ(trie.SumOfSmallest(9), 3 + 10 + 10 + 200);
+  EXPECT_EQ(trie.SumLess(10), 3);
+  EXPECT_EQ(trie.SumLess(11), 23);
+  EXPECT_EQ(trie.SumXorWith(1), (3 ^ 1) + 2 * (10 ^ 1) + (200 ^ 1));
+
+  trie.XorAll(0xF0);  // {3,10,10,200} -> {243,250,250,56}
+  EXPECT_EQ(trie.SumOfSmallest(1), 56);
+  EXPECT_EQ(trie.SumOfSmallest(2), 56 + 243);
+  EXPECT_EQ(trie.SumLess(250), 56 + 243);
+  EXPECT_EQ(trie.SumXorWith(0), 243 + 250 + 250 + 56);
+
+  trie.Erase(250);
+  EXPECT_EQ(trie.SumXorWith(0), 243 + 250 + 56);
+}
+
+TEST(BinaryTrieTest, PerQueryXorKeyOrderStatistics) {
+  BinaryTrie<std::uint32_t, 8> trie;
+  trie.Insert(1);
+  trie.Insert(2, 2);
+  trie.Insert(12);
+
+  // Under key 3: {1,2,2,12} -> {2,1,1,15}.
+  EXPECT_EQ(trie.CountXorLess(3, 2), 2);
+  EXPECT_EQ(trie.CountXorLess(3, 3), 3);
+  EXPECT_EQ(trie.CountXorLess(3, 16), 4);
+  EXPECT_EQ(trie.KthXor(3, 0), std::optional<std::uint32_t>(1));
+  EXPECT_EQ(trie.KthXor(3, 2), std::optional<std::uint32_t>(2));
+  EXPECT_EQ(trie.KthXor(3, 3), std::optional<std::uint32_t>(15));
+  EXPECT_FALSE(trie.KthXor(3, 4).has_value());
+
+  // The per-query key composes with the shared mask and leaves it untouched.
+  trie.XorAll(3);
+  EXPECT_EQ(trie.KthXor(3, 0), std::optional<std::uint32_t>(1));
+  EXPECT_EQ(trie.CountXorLess(0, 2), 2);
+  EXPECT_EQ(trie.Kth(0), std::optional<std::uint32_t>(1));
+}
+
+TEST(BinaryTrieTest, MergeFromUnionsTriesWithDifferentMasks) {
+  BinaryTrie<std::uint32_t, 8, int, /*kTrackSums=*/true> left;
+  left.Insert(1);
+  left.Insert(6);
+  left.XorAll(0x30);  // {0x31, 0x36}
+
+  BinaryTrie<std::uint32_t, 8, int, /*kTrackSums=*/true> right;
+  right.Insert(0x31);
+  right.Insert(0x80);
+  right.Insert(0x82);
+  right.XorAll(0x03);  // {0x32, 0x83, 0x81}
+
+  left.MergeFrom(std::move(right));
+  EXPECT_EQ(right.TotalCount(), 0);
+  EXPECT_EQ(left.TotalCount(), 5);
+  EXPECT_EQ(left.Kth(0), std::optional<std::uint32_t>(0x31));
+  EXPECT_EQ(left.Kth(1), std::optional<std::uint32_t>(0x32));
+  EXPECT_EQ(left.Kth(2), std::optional<std::uint32_t>(0x36));
+  EXPECT_EQ(left.Kth(3), std::optional<std::uint32_t>(0x81));
+  EXPECT_EQ(left.Kth(4), std::optional<std::uint32_t>(0x83));
+  EXPECT_EQ(left.SumLess(0x80), 0x31 + 0x32 + 0x36);
+
+  left.XorAll(0x01);
+  left.Erase(0x82);
+  EXPECT_EQ(left.Count(0x80), 1);
+  EXPECT_EQ(left.Max(), std::optional<std::uint32_t>(0x80));
+  EXPECT_EQ(left.SumXorWith(0), 0x30 + 0x33 + 0x37 + 0x80);
+
+  // The moved-from trie stays usable.
+  right.Insert(7);
+  EXPECT_EQ(right.Min(), std::optional<std::uint32_t>(7));
+}
+
+TEST(BinaryTrieTest, MergeFromRelinksNodesOfSharedPool) {
+  using Trie = BinaryTrie<std::uint32_t, 10, int, /*kTrackSums=*/true>;
+  const auto pool = std::make_shared<Trie::NodePool>();
+  // Vertex v of a rooted tree with parent (v - 1) / 3 holds one value; each
+  // subtree's multiset is toggled by the vertex's mask before it moves up.
+  constexpr int kVertices = 200;
+  std::vector<Trie> tries;
+  std::vector<std::vector<std::uint32_t>> expected(kVertices);
+  std::uint32_t state = 11;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) & 0x3FFu;
+  };
+  for (int v = 0; v < kVertices; ++v) {
+    tries.emplace_back(pool);
+    const std::uint32_t value = next();
+    tries[v].Insert(value);
+    expected[v].push_back(value);
+  }
+  for (int v = kVertices - 1; v > 0; --v) {
+    const std::uint32_t mask = next();
+    tries[v].XorAll(mask);
+    for (std::uint32_t& value : expected[v]) {
+      value ^= mask;
+    }
+    const int parent = (v - 1) / 3;
+    tries[parent].MergeFrom(std::move(tries[v]));
+    expected[parent].insert(expected[parent].end(), expected[v].begin(),
+                            expected[v].end());
+    EXPECT_EQ(tries[v].TotalCount(), 0);
+  }
+
+  std::vector<std::uint32_t>& values = expected[0];
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(tries[0].TotalCount(), kVertices);
+  std::int64_t sum = 0;
+  for (int k = 0; k < kVertices; ++k) {
+    ASSERT_EQ(tries[0].Kth(k), std::optional<std::uint32_t>(values[k])) << k;
+    sum += values[k];
+  }
+  EXPECT_EQ(tries[0].SumXorWith(0), sum);
+
+  // Merged nodes went back to the pool, so a new trie reuses them.
+  const std::size_t memory = tries[0].MemoryUsage();
+  tries[1].Insert(5);
+  EXPECT_EQ(tries[1].Count(5), 1);
+  EXPECT_EQ(tries[0].MemoryUsage(), memory);
+}
+
 TEST(BinaryTrieTest, XorAllReinterpretsKeys) {
   BinaryTrie<std::uint16_t, 8> trie;
   trie.Insert(1);
@@ -125,5 +361,353 @@ TEST(BinaryTrieTest, XorAllReinterpretsKeys) {
   EXPECT_EQ(trie.MaxXor(1).value(), 1 ^ 5);  // element 5 maximises XOR
 }
 
+TEST(BinaryTrieTest, BulkBuildAndInOrderIteration) {
+  using Trie = BinaryTrie<std::uint32_t, 12, int, true>;
+  using Entry = std::pair<std::uint32_t, int>;
+  Trie trie(std::vector<std::uint32_t>{3000, 5, 17, 5, 4095, 0, 17, 17});
+  EXPECT_EQ(trie.TotalCount(), 8);
+  EXPECT_EQ(trie.Count(17), 3);
+  EXPECT_EQ(trie.Kth(7), 4095u);
+  EXPECT_EQ(trie.SumLess<std::int64_t>(3000), 5 + 5 + 17 * 3);
+
+  std::vector<Entry> entries(trie.begin(), trie.end());
+  EXPECT_EQ(entries, (std::vector<Entry>{
+                         {0, 1}, {5, 2}, {17, 3}, {3000, 1}, {4095, 1}}));
+
+  trie.XorAll(0x00F);  // {15, 10, 30, 2999, 4080}
+  trie.Erase(10);
+  entries.assign(trie.begin(), trie.end());
+  EXPECT_EQ(entries, (std::vector<Entry>{
+                         {10, 1}, {15, 1}, {30, 3}, {2999, 1}, {4080, 1}}));
+
+  const Trie empty(std::vector<std::uint32_t>{});
+  EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST(BinaryTrieTest, InOrderIterationOverNarrowValueType) {
+  using Entry = std::pair<std::uint8_t, int>;
+  BinaryTrie<std::uint8_t> trie;
+  trie.Insert(200);
+  trie.Insert(7, 2);
+  trie.Insert(64);
+  trie.XorAll(0x81);  // {73, 134, 134, 193}
+  std::vector<Entry> entries(trie.begin(), trie.end());
+  EXPECT_EQ(entries, (std::vector<Entry>{{73, 1}, {134, 2}, {193, 1}}));
+}
+
+TEST(BinaryTrieTest, BatchQueriesMatchSingleQueries) {
+  BinaryTrie<std::uint32_t, 10> trie;
+  std::vector<std::uint32_t> queries;
+  for (std::uint32_t i = 0; i < 40; ++i) {
+    trie.Insert((i * 389) % 1024);
+    queries.push_back((i * 577 + 3) % 1024);
+  }
+  trie.XorAll(0x155);
+  trie.Erase(trie.Kth(5).value());
+
+  const auto max_xor = trie.MaxXorBatch(queries);
+  const auto min_xor = trie.MinXorBatch(queries);
+  const auto count_less = trie.CountLessBatch(queries);
+  ASSERT_EQ(max_xor.size(), queries.size());
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    EXPECT_EQ(max_xor[i], trie.MaxXor(queries[i]));
+    EXPECT_EQ(min_xor[i], trie.MinXor(queries[i]));
+    EXPECT_EQ(count_less[i], trie.CountLess(queries[i]));
+  }
+
+  const BinaryTrie<std::uint32_t, 10> empty;
+  EXPECT_EQ(empty.MaxXorBatch({1, 2}),
+            (std::vector<std::optional<std::uint32_t>>(2)));
+  EXPECT_EQ(empty.CountLessBatch({1, 2}), (std::vector<int>{0, 0}));
+}
+
+TEST(BinaryTrieTest, RollbackUndoesUpdatesInLifoOrder) {
+  BinaryTrie<std::uint32_t, 8, int, true> trie;
+  trie.Insert(3);
+  trie.Insert(9, 2);
+  const auto outer = trie.MakeCheckpoint();
+  trie.Insert(200);
+  trie.XorAll(0x0F);  // {12, 6, 6, 199}
+  trie.Erase(12);
+
+  const auto inner = trie.MakeCheckpoint();
+  EXPECT_EQ(trie.PopMax(), std::optional<std::uint32_t>(199));
+  trie.Insert(77);
+  EXPECT_EQ(trie.TotalCount(), 3);
+
+  trie.Rollback(inner);
+  EXPECT_EQ(trie.TotalCount(), 3);
+  EXPECT_EQ(trie.Max(), std::optional<std::uint32_t>(199));
+  EXPECT_EQ(trie.Count(77), 0);
+
+  trie.Rollback(outer);
+  EXPECT_EQ(trie.TotalCount(), 3);
+  EXPECT_EQ(trie.Count(3), 1);
+  EXPECT_EQ(trie.Count(9), 2);
+  EXPECT_EQ(trie.Count(200), 0);
+  EXPECT_EQ(trie.SumLess<std::int64_t>(255), 3 + 9 + 9);
+  EXPECT_EQ(trie.Kth(2), std::optional<std::uint32_t>(9));
+
+  trie.ClearCheckpoints();
+  trie.Insert(1);
+  EXPECT_EQ(trie.Min(), std::optional<std::uint32_t>(1));
+}
+
+TEST(BinaryTrieTest, PrefixAndRangeXorMatchBruteForce) {
+  BinaryTrie<std::uint32_t, 8, int, true> trie;
+  std::map<std::uint32_t, int> expected;
+  std::uint32_t state = 7;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+  };
+  const auto xor_matching = [&expected](auto in_scope, std::uint32_t mask) {
+    std::map<std::uint32_t, int> updated;
+    for (const auto& [value, count] : expected) {
+      updated[in_scope(value) ? value ^ mask : value] += count;
+    }
+    expected = std::move(updated);
+  };
+  for (int step = 0; step < 600; ++step) {
+    const std::uint32_t value = next() & 0xFFu;
+    switch (next() % 5) {
+      case 0:
+        trie.Insert(value);
+        ++expected[value];
+        break;
+      case 1:
+        trie.Erase(value);
+        if (auto it = expected.find(value); it != expected.end()) {
+          if (--it->second == 0) {
+            expected.erase(it);
+          }
+        }
+        break;
+      case 2:
+        trie.XorAll(value);
+        xor_matching([](std::uint32_t) { return true; }, value);
+        break;
+      case 3: {
+        const int length = static_cast<int>(next() % 9);
+        const std::uint32_t mask = value & ((1u << (8 - length)) - 1);
+        trie.XorPrefix(value, length, mask);
+        const int shift = 8 - length;
+        xor_matching(
+            [&](std::uint32_t v) { return (v >> shift) == (value >> shift); },
+            mask);
+        break;
+      }
+      default: {
+        // Unions of aligned 2^k blocks with mask < 2^k are plain XORs.
+        const int k = static_cast<int>(next() % 8);
+        const std::uint32_t lo = value >> k << k;
+        const std::uint32_t blocks = 1 + next() % ((256 - lo) >> k);
+        const std::uint32_t hi = lo + (blocks << k) - 1;
+        const std::uint32_t mask = next() & ((1u << k) - 1);
+        trie.XorRange(lo, hi, mask);
+        xor_matching(
+            [&](std::uint32_t v) { return lo <= v && v <= hi; }, mask);
+        break;
+      }
+    }
+    if (step % 20 == 0) {
+      std::vector<std::pair<std::uint32_t, int>> actual(trie.begin(),
+                                                        trie.end());
+      ASSERT_EQ(actual,
+                (std::vector<std::pair<std::uint32_t, int>>(
+                    expected.begin(), expected.end())));
+      std::int64_t sum = 0;
+      for (const auto& [v, count] : expected) {
+        sum += static_cast<std::int64_t>(v) * count;
+      }
+      ASSERT_EQ(trie.SumLess<std::int64_t>(255) +
+                    255 * static_cast<std::int64_t>(trie.Count(255)),
+                sum);
+    }
+  }
+
+  // The mask must fit in the smallest aligned block of the range.
+  using Values = std::vector<std::pair<std::uint32_t, int>>;
+  BinaryTrie<std::uint32_t, 8> small;
+  small.Insert(2);
+  small.Insert(4);
+  small.Insert(6);
+  small.Insert(9);
+  // [0, 2] splits into [0, 1] and [2, 2], which cannot take bit 0.
+  EXPECT_DEBUG_DEATH(small.XorRange(0, 2, 1), "smallest aligned block");
+  // [4, 9] splits into [4, 7] and [8, 9], which cannot take bit 1.
+  EXPECT_DEBUG_DEATH(small.XorRange(4, 9, 0b11), "smallest aligned block");
+  EXPECT_EQ(Values(small.begin(), small.end()),
+            (Values{{2, 1}, {4, 1}, {6, 1}, {9, 1}}));
+  small.Erase(2);
+  const auto checkpoint = small.MakeCheckpoint();
+  small.XorRange(4, 9, 0b1);
+  EXPECT_EQ(Values(small.begin(), small.end()),
+            (Values{{5, 1}, {7, 1}, {8, 1}}));
+  small.XorPrefix(0b00000100, 6, 0b11);
+  EXPECT_EQ(Values(small.begin(), small.end()),
+            (Values{{4, 1}, {6, 1}, {8, 1}}));
+  small.Rollback(checkpoint);
+  EXPECT_EQ(Values(small.begin(), small.end()),
+            (Values{{4, 1}, {6, 1}, {9, 1}}));
+}
+
+TEST(BinaryTrieTest, DistinctCountAndCachedExtremes) {
+  BinaryTrie<std::uint32_t, 8> trie;
+  std::map<std::uint32_t, int> expected;
+  const auto check = [&] {
+    ASSERT_EQ(trie.DistinctCount(), static_cast<int>(expected.size()));
+    if (expected.empty()) {
+      EXPECT_EQ(trie.Min(), std::nullopt);
+      EXPECT_EQ(trie.Max(), std::nullopt);
+      return;
+    }
+    EXPECT_EQ(trie.Min(), expected.begin()->first);
+    EXPECT_EQ(trie.Max(), expected.rbegin()->first);
+    int k = 0;
+    for (const auto& [value, count] : expected) {
+      ASSERT_EQ(trie.KthDistinct(k++), value);
+    }
+    EXPECT_EQ(trie.KthDistinct(k), std::nullopt);
+  };
+  std::uint32_t state = 99;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+  };
+  for (int step = 0; step < 400; ++step) {
+    const std::uint32_t value = next() & 0xFFu;
+    const std::uint32_t op = next() % 8;
+    if (op < 4) {
+      const int count = 1 + static_cast<int>(next() % 3);
+      trie.Insert(value, count);
+      expected[value] += count;
+    } else if (op < 7) {
+      // Bias erasures toward the current extremes.
+      std::uint32_t target = value;
+      if (!expected.empty() && op == 4) {
+        target = expected.begin()->first;
+      } else if (!expected.empty() && op == 5) {
+        target = expected.rbegin()->first;
+      }
+      trie.Erase(target);
+      if (auto it = expected.find(target); it != expected.end()) {
+        if (--it->second == 0) {
+          expected.erase(it);
+        }
+      }
+    } else {
+      trie.XorAll(value);
+      std::map<std::uint32_t, int> updated;
+      for (const auto& [v, count] : expected) {
+        updated[v ^ value] += count;
+      }
+      expected = std::move(updated);
+    }
+    check();
+  }
+
+  // Bulk build, merge and rollback keep the counts and extremes.
+  BinaryTrie<std::uint32_t, 8> other(std::vector<std::uint32_t>{7, 7, 250});
+  EXPECT_EQ(other.DistinctCount(), 2);
+  EXPECT_EQ(other.Max(), std::optional<std::uint32_t>(250));
+  trie.MergeFrom(std::move(other));
+  expected[7] += 2;
+  ++expected[250];
+  check();
+  const auto checkpoint = trie.MakeCheckpoint();
+  trie.Insert(255);
+  trie.Erase(expected.begin()->first, 100);
+  trie.Rollback(checkpoint);
+  check();
+}
+
+TEST(BinaryTrieTest, PairXorAggregatesMatchBruteForce) {
+  BinaryTrie<std::uint32_t, 9> trie;
+  BinaryTrie<std::uint32_t, 9, int, true> summed;
+  std::vector<std::uint32_t> values;
+  std::uint32_t state = 5;
+  for (int i = 0; i < 120; ++i) {
+    state = state * 1103515245u + 12345u;
+    const std::uint32_t value = (state >> 12) & 0x1FFu;
+    const int count = i % 7 == 0 ? 3 : 1;
+    trie.Insert(value, count);
+    summed.Insert(value, count);
+    values.insert(values.end(), count, value);
+  }
+  // Tags and the global mask must not change the pairwise XORs.
+  trie.XorAll(0x155);
+  trie.XorPrefix(0x100, 2, 0x2A);
+  summed.XorAll(0x155);
+  summed.XorPrefix(0x100, 2, 0x2A);
+  summed.XorAll(0x0F0);
+  for (std::uint32_t& value : values) {
+    value ^= 0x155;
+    if ((value >> 7) == (0x100u >> 7)) {
+      value ^= 0x2A;
+    }
+  }
+
+  std::vector<std::uint32_t> pair_xors;
+  std::int64_t sum = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    for (std::size_t j = i + 1; j < values.size(); ++j) {
+      pair_xors.push_back(values[i] ^ values[j]);
+      sum += values[i] ^ values[j];
+    }
+  }
+  std::sort(pair_xors.begin(), pair_xors.end());
+  const auto total = static_cast<std::int64_t>(pair_xors.size());
+
+  EXPECT_EQ(trie.SumPairXor(), sum);
+  EXPECT_EQ(summed.SumPairXor(), trie.SumPairXor());
+  for (std::uint32_t limit = 0; limit < 512; limit += 7) {
+    const auto expected = std::upper_bound(pair_xors.begin(),
+                                           pair_xors.end(), limit) -
+                          pair_xors.begin();
+    ASSERT_EQ(trie.CountPairsXorAtMost(limit), expected) << limit;
+  }
+  EXPECT_EQ(trie.CountPairsXorAtMost(511), total);
+  for (std::int64_t k = 0; k < total; k += 13) {
+    ASSERT_EQ(trie.KthPairXor(k), pair_xors[k]) << k;
+  }
+  EXPECT_EQ(trie.KthPairXor(total - 1), pair_xors.back());
+  EXPECT_EQ(trie.KthPairXor(total), std::nullopt);
+
+  const BinaryTrie<std::uint32_t, 9> single(std::vector<std::uint32_t>{4});
+  EXPECT_EQ(single.KthPairXor(0), std::nullopt);
+  EXPECT_EQ(single.CountPairsXorAtMost(511), 0);
+  EXPECT_EQ(single.SumPairXor(), 0);
+}
+
+TEST(BinaryTrieTest, PairXorAggregatesOverNarrowValueType) {
+  BinaryTrie<std::uint8_t> trie;
+  const std::vector<std::uint8_t> values = {3, 200, 200, 77, 128, 255};
+  for (const std::uint8_t value : values) {
+    trie.Insert(value);
+  }
+  trie.XorAll(0x5A);
+
+  std::vector<int> pair_xors;
+  std::int64_t sum = 0;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    for (std::size_t j = i + 1; j < values.size(); ++j) {
+      pair_xors.push_back(values[i] ^ values[j]);
+      sum += values[i] ^ values[j];
+    }
+  }
+  std::sort(pair_xors.begin(), pair_xors.end());
+
+  EXPECT_EQ(trie.SumPairXor(), sum);
+  EXPECT_EQ(trie.CountPairsXorAtMost(0), 1);
+  EXPECT_EQ(trie.CountPairsXorAtMost(255),
+            static_cast<std::int64_t>(pair_xors.size()));
+  for (std::size_t k = 0; k < pair_xors.size(); ++k) {
+    ASSERT_EQ(trie.KthPairXor(static_cast<std::int64_t>(k)),
+              std::optional<std::uint8_t>(pair_xors[k]))
+        << k;
+  }
+}
+
 }  // namespace
 }  // namespace hotaosa
@@ -0,0 +1,52 @@
+#include "hotaosa/ds/bit_vector.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(BitVectorTest, RankMatchesPrefixCounts) {
+  BitVector bits;
+  std::vector<bool> expected;
+  for (std::size_t i = 0; i < 1500; ++i) {
+    const bool bit = (i * i + 3 * i) % 7 < 3;
+    bits.PushBack(bit);
+    expected.push_back(bit);
+  }
+  bits.Set(1024);
+  expected[1024] = true;
+  bits.Set(5, false);
+  expected[5] = false;
+  bits.Build();
+
+  ASSERT_EQ(bits.Size(), expected.size());
+  std::size_t ones = 0;
+  for (std::size_t i = 0; i <= expected.size(); ++i) {
+    EXPECT_EQ(bits.Rank1(i), ones);
+    EXPECT_EQ(bits.Rank0(i), i - ones);
+    if (i < expected.size()) {
+      EXPECT_EQ(bits.Get(i), expected[i]);
+      ones += expected[i] ? 1 : 0;
+    }
+  }
+}
+
+TEST(BitVectorTest, BlockBoundariesAndEmpty) {
+  BitVector empty;
+  empty.Build();
+  EXPECT_EQ(empty.Rank1(0), 0u);
+
+  BitVector bits(512);
+  bits.Set(0);
+  bits.Set(511);
+  bits.Build();
+  EXPECT_EQ(bits.Rank1(511), 1u);
+  EXPECT_EQ(bits.Rank1(512), 2u);
+  EXPECT_FALSE(bits.Get(256));
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,464 @@
+#ifndef HOTAOSA_DS_DENSE_BINARY_TRIE_H_
+#define HOTAOSA_DS_DENSE_BINARY_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "hotaosa/ds/binary_trie.h"
+
+namespace hotaosa {
+
+// Widest universe handled by DenseBinaryTrie; FastBinaryTrie falls back to the
+// node-based BinaryTrie above it.
+inline constexpr int kDenseBinaryTrieMaxBits = 24;
+
+// DenseBinaryTrie is a pointer-free BinaryTrie backend for small universes
+// (kNumBits <= 24). Presence lives in a hierarchical 64-ary bitset answering
+// LowerBound/Prev/Min/Max with one tzcnt/lzcnt per level and MaxXor/MinXor
+// with one masked word test per bit. Every bitset word carries the total
+// multiplicity below it, so CountLess/Kth scan at most 63 counts per level
+// and finish in the leaf word with a popcount. A value stored more than once
+// keeps its multiplicity in a hash map; leaf words holding none of those
+// count by popcount alone. The lazy XOR mask permutes bit positions inside
+// each word and word positions across it, so every query honours it in place.
+// Memory: ~2^kNumBits bits plus 2^(kNumBits - 6) * sizeof(CountType) bytes
+// (1 MiB for int at 24 bits) plus one map entry per repeated value.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class DenseBinaryTrie {
+  static_assert(kNumBits > 0, "DenseBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= kDenseBinaryTrieMaxBits,
+                "DenseBinaryTrie is limited to small universes");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "DenseBinaryTrie bit width exceeds ValueType digits");
+
+ public:
+  DenseBinaryTrie() : repeated_(kLeafWords) {
+    std::size_t num_bits = std::size_t{1} << kNumBits;
+    do {
+      const std::size_t num_words = (num_bits + kWordBits - 1) / kWordBits;
+      levels_.emplace_back(num_words, 0);
+      word_counts_.emplace_back(num_words, 0);
+      num_bits = num_words;
+    } while (num_bits > 1);
+  }
+
+  DenseBinaryTrie(const DenseBinaryTrie&) = delete;
+  DenseBinaryTrie& operator=(const DenseBinaryTrie&) = delete;
+  DenseBinaryTrie(DenseBinaryTrie&&) = delete;
+  DenseBinaryTrie& operator=(DenseBinaryTrie&&) = delete;
+
+  // Inserts one copy of `value`. O(kNumBits).
+  void Insert(ValueType value) { Insert(value, static_cast<CountType>(1)); }
+
+  // Inserts `count` copies of `value`. O(kNumBits / 6) expected.
+  void Insert(ValueType value, CountType count) {
+    assert(count >= 0);
+    if (count == 0) {
+      return;
+    }
+    assert((value & ~BitMask()) == 0);
+    const std::size_t stored_value = ToStored(value);
+    SetCount(stored_value, StoredCount(stored_value) + count);
+    AddToWordCounts(stored_value, count);
+  }
+
+  // Removes one copy of `value` when present. O(kNumBits).
+  void Erase(ValueType value) { Erase(value, static_cast<CountType>(1)); }
+
+  // Removes up to `count` copies of `value`. O(kNumBits / 6) expected.
+  void Erase(ValueType value, CountType count) {
+    assert(count >= 0);
+    if (count == 0) {
+      return;
+    }
+    assert((value & ~BitMask()) == 0);
+    const std::size_t stored_value = ToStored(value);
+    const CountType current = StoredCount(stored_value);
+    const CountType removable = std::min(count, current);
+    if (removable == 0) {
+      return;
+    }
+    SetCount(stored_value, current - removable);
+    AddToWordCounts(stored_value, -removable);
+  }
+
+  // Returns the multiplicity of `value` stored in the trie. O(1) expected.
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return StoredCount(ToStored(value));
+  }
+
+  // Total multiplicity stored in the trie. O(1).
+  [[nodiscard]] CountType TotalCount() const {
+    return word_counts_.back()[0];
+  }
+
+  // Returns whether the multiset currently contains `value`. O(1).
+  [[nodiscard]] bool Contains(ValueType value) const {
+    return Count(value) > static_cast<CountType>(0);
+  }
+
+  // Returns how many stored values are strictly less than `value`. Sums the
+  // counts of the lower siblings on each level, then popcounts the leaf word.
+  // O(64 * kNumBits / 6).
+  [[nodiscard]] CountType CountLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const std::size_t actual = value;
+    const auto mask = static_cast<std::size_t>(xor_mask_);
+    const std::size_t leaf_word = (actual ^ mask) >> kWordShift;
+    const std::uint64_t below =
+        ActualWord(0, actual >> kWordShift) &
+        ((std::uint64_t{1} << (actual & (kWordBits - 1))) - 1);
+    CountType result = CountBits(leaf_word, below);
+    const int num_levels = static_cast<int>(levels_.size());
+    for (int level = 1; level < num_levels; ++level) {
+      const int shift = kWordShift * level;
+      const std::size_t position = (actual >> shift) & (kWordBits - 1);
+      const std::size_t level_mask = (mask >> shift) & (kWordBits - 1);
+      const std::size_t first =
+          ((actual ^ mask) >> (shift + kWordShift)) << kWordShift;
+      for (std::size_t child = 0; child < position; ++child) {
+        result += word_counts_[level - 1][first + (child ^ level_mask)];
+      }
+    }
+    return result;
+  }
+
+  // Returns how many stored values are strictly greater than `value`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountGreater(ValueType value) const {
+    return static_cast<CountType>(TotalCount() - CountLess(value) -
+                                  Count(value));
+  }
+
+  // Returns the k-th smallest value (0-indexed). Descends through the word
+  // counts in actual order, then selects inside the leaf word.
+  // O(64 * kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    if (k < 0 || k >= TotalCount()) {
+      return std::nullopt;
+    }
+    const auto mask = static_cast<std::size_t>(xor_mask_);
+    // Stored index of the word containing the answer on the current level.
+    std::size_t word_index = 0;
+    for (int level = static_cast<int>(levels_.size()) - 1; level > 0;
+         --level) {
+      const std::size_t level_mask =
+          (mask >> (kWordShift * level)) & (kWordBits - 1);
+      const std::size_t first = word_index << kWordShift;
+      for (std::size_t child = 0;; ++child) {
+        assert(child < kWordBits);
+        const std::size_t stored_child = first + (child ^ level_mask);
+        if (stored_child >= word_counts_[level - 1].size()) {
+          continue;
+        }
+        const CountType count = word_counts_[level - 1][stored_child];
+        if (k < count) {
+          word_index = stored_child;
+          break;
+        }
+        k -= count;
+      }
+    }
+    const std::size_t actual_word = word_index ^ (mask >> kWordShift);
+    std::uint64_t word = ActualWord(0, actual_word);
+    for (;;) {
+      assert(word != 0);
+      const int position = std::countr_zero(word);
+      const CountType count =
+          repeated_[word_index] == 0
+              ? CountType{1}
+              : StoredCount(((actual_word << kWordShift) | position) ^ mask);
+      if (k < count) {
+        return static_cast<ValueType>((actual_word << kWordShift) | position);
+      }
+      k -= count;
+      word &= word - 1;
+    }
+  }
+
+  // Returns minimal value >= `value`. O(kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> LowerBound(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return NextAtLeast(value);
+  }
+
+  // Returns minimal value > `value`. O(kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> UpperBound(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    if (value == BitMask()) {
+      return std::nullopt;
+    }
+    return NextAtLeast(std::size_t{value} + 1);
+  }
+
+  // Returns maximal value <= `value`. O(kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> Prev(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return PrevAtMost(value);
+  }
+
+  // Returns the smallest stored value. O(kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> Min() const { return NextAtLeast(0); }
+
+  // Returns the largest stored value. O(kNumBits / 6).
+  [[nodiscard]] std::optional<ValueType> Max() const {
+    return PrevAtMost(BitMask());
+  }
+
+  // Returns the maximum value of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(ValueType value) const {
+    return FindExtremeXor(value, true);
+  }
+
+  // Returns the minimum value of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(ValueType value) const {
+    return FindExtremeXor(value, false);
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(1).
+  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+
+ private:
+  static constexpr int kWordBits = 64;
+  static constexpr int kWordShift = 6;
+  static constexpr std::size_t kLeafWords =
+      ((std::size_t{1} << kNumBits) + kWordBits - 1) / kWordBits;
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  [[nodiscard]] std::size_t ToStored(ValueType value) const {
+    return (value ^ xor_mask_) & BitMask();
+  }
+
+  // Reorders the bits of `word` so that position p moves to p ^ `shuffle`
+  // (shuffle < 64), one swap stage per set bit of `shuffle`.
+  [[nodiscard]] static constexpr std::uint64_t PermuteWord(
+      std::uint64_t word, std::size_t shuffle) {
+    constexpr std::array<std::uint64_t, kWordShift> kLowHalves{{
+        0x5555'5555'5555'5555ull,
+        0x3333'3333'3333'3333ull,
+        0x0F0F'0F0F'0F0F'0F0Full,
+        0x00FF'00FF'00FF'00FFull,
+        0x0000'FFFF'0000'FFFFull,
+        0x0000'0000'FFFF'FFFFull,
+    }};
+    for (int stage = 0; stage < kWordShift; ++stage) {
+      if (((shuffle >> stage) & 1) != 0) {
+        const int width = 1 << stage;
+        word = ((word & kLowHalves[stage]) << width) |
+               ((word >> width) & kLowHalves[stage]);
+      }
+    }
+    return word;
+  }
+
+  // Returns word `word_index` of `level` with bits laid out in actual
+  // (post-mask) order.
+  [[nodiscard]] std::uint64_t ActualWord(int level,
+                                         std::size_t word_index) const {
+    const std::size_t level_mask =
+        static_cast<std::size_t>(xor_mask_) >> (kWordShift * level);
+    return PermuteWord(levels_[level][word_index ^ (level_mask >> kWordShift)],
+                       level_mask & (kWordBits - 1));
+  }
+
+  [[nodiscard]] CountType StoredCount(std::size_t stored_value) const {
+    const std::size_t word_index = stored_value >> kWordShift;
+    if (((levels_[0][word_index] >> (stored_value & (kWordBits - 1))) & 1) ==
+        0) {
+      return 0;
+    }
+    if (repeated_[word_index] == 0) {
+      return 1;
+    }
+    const auto it = multiplicities_.find(stored_value);
+    return it == multiplicities_.end() ? CountType{1} : it->second;
+  }
+
+  // Sets the multiplicity of `stored_value` to `count`, updating presence and
+  // the repeated-value bookkeeping but not the word counts.
+  void SetCount(std::size_t stored_value, CountType count) {
+    const CountType previous = StoredCount(stored_value);
+    const std::size_t word_index = stored_value >> kWordShift;
+    if (count > 1) {
+      multiplicities_[stored_value] = count;
+      if (previous <= 1) {
+        ++repeated_[word_index];
+      }
+    } else if (previous > 1) {
+      multiplicities_.erase(stored_value);
+      --repeated_[word_index];
+    }
+    if (previous == 0 && count > 0) {
+      SetPresent(stored_value);
+    } else if (previous > 0 && count == 0) {
+      ClearPresent(stored_value);
+    }
+  }
+
+  void AddToWordCounts(std::size_t stored_value, CountType delta) {
+    for (auto& counts : word_counts_) {
+      stored_value >>= kWordShift;
+      counts[stored_value] += delta;
+    }
+  }
+
+  // Total multiplicity of the set bits of leaf word `word_index` selected by
+  // `bits`, given in actual order.
+  [[nodiscard]] CountType CountBits(std::size_t word_index,
+                                    std::uint64_t bits) const {
+    if (repeated_[word_index] == 0) {
+      return static_cast<CountType>(std::popcount(bits));
+    }
+    const std::size_t base =
+        (word_index << kWordShift) ^
+        (static_cast<std::size_t>(xor_mask_) & (kWordBits - 1));
+    CountType result = 0;
+    for (; bits != 0; bits &= bits - 1) {
+      result += StoredCount(base ^ std::countr_zero(bits));
+    }
+    return result;
+  }
+
+  // Returns whether any value lies in the stored block
+  // [prefix << bit, (prefix + 1) << bit).
+  [[nodiscard]] bool BlockOccupied(std::size_t prefix, int bit) const {
+    const int level = bit / kWordShift;
+    const int width = 1 << (bit % kWordShift);
+    const std::size_t first = prefix * width;
+    const std::uint64_t bits = ((std::uint64_t{1} << width) - 1)
+                               << (first & (kWordBits - 1));
+    return (levels_[level][first >> kWordShift] & bits) != 0;
+  }
+
+  void SetPresent(std::size_t stored_value) {
+    for (auto& level : levels_) {
+      level[stored_value >> kWordShift] |= std::uint64_t{1}
+                                           << (stored_value & (kWordBits - 1));
+      stored_value >>= kWordShift;
+    }
+  }
+
+  void ClearPresent(std::size_t stored_value) {
+    for (auto& level : levels_) {
+      std::uint64_t& word = level[stored_value >> kWordShift];
+      word &= ~(std::uint64_t{1} << (stored_value & (kWordBits - 1)));
+      if (word != 0) {
+        return;
+      }
+      stored_value >>= kWordShift;
+    }
+  }
+
+  [[nodiscard]] std::optional<ValueType> NextAtLeast(std::size_t idx) const {
+    const int num_levels = static_cast<int>(levels_.size());
+    for (int level = 0; level < num_levels; ++level) {
+      const std::size_t word_index = idx >> kWordShift;
+      if (word_index >= levels_[level].size()) {
+        return std::nullopt;
+      }
+      const std::uint64_t word =
+          ActualWord(level, word_index) >> (idx & (kWordBits - 1));
+      if (word == 0) {
+        idx = word_index + 1;
+        continue;
+      }
+      idx += std::countr_zero(word);
+      for (int lower = level - 1; lower >= 0; --lower) {
+        idx = (idx << kWordShift) + std::countr_zero(ActualWord(lower, idx));
+      }
+      return static_cast<ValueType>(idx);
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]] std::optional<ValueType> PrevAtMost(std::size_t idx) const {
+    const int num_levels = static_cast<int>(levels_.size());
+    for (int level = 0; level < num_levels; ++level) {
+      const std::size_t word_index = idx >> kWordShift;
+      const std::uint64_t word = ActualWord(level, word_index)
+                                 << (kWordBits - 1 - (idx & (kWordBits - 1)));
+      if (word == 0) {
+        if (word_index == 0) {
+          return std::nullopt;
+        }
+        idx = word_index - 1;
+        continue;
+      }
+      idx -= std::countl_zero(word);
+      for (int lower = level - 1; lower >= 0; --lower) {
+        idx = (idx << kWordShift) + (kWordBits - 1) -
+              std::countl_zero(ActualWord(lower, idx));
+      }
+      return static_cast<ValueType>(idx);
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(ValueType value,
+                                                        bool maximize) const {
+    assert((value & ~BitMask()) == 0);
+    if (TotalCount() <= 0) {
+      return std::nullopt;
+    }
+    const std::size_t key = ToStored(value);
+    std::size_t prefix = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const std::size_t desired =
+          ((key >> bit) & 1) ^ static_cast<std::size_t>(maximize);
+      prefix = 2 * prefix + desired;
+      if (!BlockOccupied(prefix, bit)) {
+        prefix ^= 1;
+      }
+    }
+    return static_cast<ValueType>(prefix ^ key);
+  }
+
+  // levels_[0] holds one presence bit per stored value; bit i of level l + 1
+  // is set when word i of level l is non-zero.
+  std::vector<std::vector<std::uint64_t>> levels_;
+  // word_counts_[l][i]: total multiplicity under word i of levels_[l].
+  std::vector<std::vector<CountType>> word_counts_;
+  // Number of values stored more than once in each leaf word.
+  std::vector<std::uint8_t> repeated_;
+  // Multiplicity of every value stored more than once, by stored value.
+  std::unordered_map<std::size_t, CountType> multiplicities_;
+  ValueType xor_mask_{0};
+};
+
+// Picks DenseBinaryTrie for universes of at most kDenseBinaryTrieMaxBits bits
+// and the node-based BinaryTrie otherwise. Only DenseBinaryTrie's interface is
+// guaranteed: Insert, Erase, Count, TotalCount, Contains, CountLess,
+// CountGreater, Kth, LowerBound, UpperBound, Prev, Min, Max, MaxXor, MinXor
+// and XorAll. BinaryTrie's other queries (Rank, KthXor, PopMin, XorRange,
+// the batch and sum queries, iteration, ...) compile only above the cutoff.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+using FastBinaryTrie =
+    std::conditional_t<(kNumBits <= kDenseBinaryTrieMaxBits),
+                       DenseBinaryTrie<ValueType, kNumBits, CountType>,
+                       BinaryTrie<ValueType, kNumBits, CountType>>;
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_DENSE_BINARY_TRIE_H_
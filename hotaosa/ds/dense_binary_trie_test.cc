@@ -0,0 +1,148 @@
+#include "hotaosa/ds/dense_binary_trie.h"
+
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+static_assert(std::is_same_v<FastBinaryTrie<std::uint32_t, 20>,
+                             DenseBinaryTrie<std::uint32_t, 20>>);
+static_assert(std::is_same_v<FastBinaryTrie<std::uint32_t>,
+                             BinaryTrie<std::uint32_t>>);
+
+// Exercises the interface FastBinaryTrie guarantees for either backend.
+template <typename Trie>
+void ExpectCommonInterface() {
+  Trie trie;
+  trie.Insert(3);
+  trie.Insert(9, 2);
+  trie.Erase(9);
+  trie.Erase(3, 1);
+  trie.Insert(12);
+  EXPECT_EQ(trie.TotalCount(), 2);
+  EXPECT_EQ(trie.Count(9), 1);
+  EXPECT_TRUE(trie.Contains(12));
+  EXPECT_EQ(trie.CountLess(12), 1);
+  EXPECT_EQ(trie.CountGreater(9), 1);
+  EXPECT_EQ(trie.Kth(1), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.LowerBound(10), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.UpperBound(9), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.Prev(11), std::optional<std::uint32_t>(9));
+  EXPECT_EQ(trie.Min(), std::optional<std::uint32_t>(9));
+  EXPECT_EQ(trie.Max(), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.MaxXor(0), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.MinXor(8), std::optional<std::uint32_t>(1));
+  trie.XorAll(1);
+  EXPECT_EQ(trie.Min(), std::optional<std::uint32_t>(8));
+}
+
+TEST(DenseBinaryTrieTest, FastBinaryTrieCommonInterface) {
+  ExpectCommonInterface<FastBinaryTrie<std::uint32_t, 20>>();
+  ExpectCommonInterface<FastBinaryTrie<std::uint32_t>>();
+}
+
+TEST(DenseBinaryTrieTest, InsertEraseAndCount) {
+  DenseBinaryTrie<std::uint32_t, 16> trie;
+  EXPECT_EQ(trie.TotalCount(), 0);
+
+  trie.Insert(5);
+  trie.Insert(0);
+  trie.Insert(5);
+  trie.Insert(65535);
+
+  EXPECT_EQ(trie.TotalCount(), 4);
+  EXPECT_EQ(trie.Count(5), 2);
+  EXPECT_TRUE(trie.Contains(65535));
+  EXPECT_FALSE(trie.Contains(7));
+
+  trie.Erase(5, 10);
+  EXPECT_EQ(trie.Count(5), 0);
+  EXPECT_EQ(trie.TotalCount(), 2);
+  EXPECT_EQ(trie.LowerBound(1), std::optional<std::uint32_t>(65535));
+}
+
+TEST(DenseBinaryTrieTest, OrderQueries) {
+  DenseBinaryTrie<std::uint32_t, 20> trie;
+  trie.Insert(12);
+  trie.Insert(4100, 2);
+  trie.Insert(300000);
+
+  EXPECT_EQ(trie.CountLess(4100), 1);
+  EXPECT_EQ(trie.CountLess(4101), 3);
+  EXPECT_EQ(trie.CountGreater(12), 3);
+  EXPECT_EQ(trie.Kth(2), std::optional<std::uint32_t>(4100));
+  EXPECT_EQ(trie.Kth(3), std::optional<std::uint32_t>(300000));
+  EXPECT_FALSE(trie.Kth(4).has_value());
+
+  EXPECT_EQ(trie.LowerBound(13), std::optional<std::uint32_t>(4100));
+  EXPECT_EQ(trie.UpperBound(4100), std::optional<std::uint32_t>(300000));
+  EXPECT_FALSE(trie.UpperBound(300000).has_value());
+  EXPECT_EQ(trie.Prev(299999), std::optional<std::uint32_t>(4100));
+  EXPECT_FALSE(trie.Prev(11).has_value());
+  EXPECT_EQ(trie.Min(), std::optional<std::uint32_t>(12));
+  EXPECT_EQ(trie.Max(), std::optional<std::uint32_t>(300000));
+}
+
+TEST(DenseBinaryTrieTest, XorMaskPermutesOrder) {
+  DenseBinaryTrie<std::uint32_t, 12> trie;
+  trie.Insert(1);
+  trie.Insert(6);
+  trie.Insert(0x800);
+
+  EXPECT_EQ(trie.MaxXor(6), std::optional<std::uint32_t>(6 ^ 0x800));
+  EXPECT_EQ(trie.MinXor(6), std::optional<std::uint32_t>(0));
+
+  trie.XorAll(0x843);  // {1,6,0x800} -> {0x842,0x845,0x043}
+  EXPECT_TRUE(trie.Contains(0x842));
+  EXPECT_FALSE(trie.Contains(1));
+  EXPECT_EQ(trie.Min(), std::optional<std::uint32_t>(0x043));
+  EXPECT_EQ(trie.Max(), std::optional<std::uint32_t>(0x845));
+  EXPECT_EQ(trie.LowerBound(0x044), std::optional<std::uint32_t>(0x842));
+  EXPECT_EQ(trie.Prev(0x844), std::optional<std::uint32_t>(0x842));
+  EXPECT_EQ(trie.CountLess(0x845), 2);
+  EXPECT_EQ(trie.Kth(1), std::optional<std::uint32_t>(0x842));
+  EXPECT_EQ(trie.MaxXor(0), std::optional<std::uint32_t>(0x845));
+}
+
+TEST(DenseBinaryTrieTest, MultisetMatchesNodeBasedTrie) {
+  DenseBinaryTrie<std::uint32_t, 14> dense;
+  BinaryTrie<std::uint32_t, 14> reference;
+  std::uint32_t state = 99;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+  };
+  for (int round = 0; round < 3000; ++round) {
+    // Few distinct values so that repeats and emptied words are common.
+    const std::uint32_t value = (next() % 300) * 53 % (1u << 14);
+    const int count = static_cast<int>(next() % 3) + 1;
+    if (next() % 3 == 0) {
+      dense.Erase(value, count);
+      reference.Erase(value, count);
+    } else {
+      dense.Insert(value, count);
+      reference.Insert(value, count);
+    }
+    if (round % 500 == 0) {
+      const std::uint32_t mask = next() & 0x3FFFu;
+      dense.XorAll(mask);
+      reference.XorAll(mask);
+    }
+    const std::uint32_t query = next() & 0x3FFFu;
+    ASSERT_EQ(dense.TotalCount(), reference.TotalCount());
+    ASSERT_EQ(dense.Count(query), reference.Count(query)) << query;
+    ASSERT_EQ(dense.CountLess(query), reference.CountLess(query)) << query;
+    const int k = static_cast<int>(next() % (reference.TotalCount() + 1));
+    ASSERT_EQ(dense.Kth(k), reference.Kth(k)) << k;
+    ASSERT_EQ(dense.MaxXor(query), reference.MaxXor(query)) << query;
+    ASSERT_EQ(dense.MinXor(query), reference.MinXor(query)) << query;
+    ASSERT_EQ(dense.LowerBound(query), reference.LowerBound(query)) << query;
+  }
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,201 @@
+#ifndef HOTAOSA_DS_MIN_PAIR_XOR_TRIE_H_
+#define HOTAOSA_DS_MIN_PAIR_XOR_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace hotaosa {
+
+// MinPairXorTrie is a BinaryTrie multiset that maintains min(a_i XOR a_j) over
+// all pairs i != j. Pairs inside one child of a node XOR below the node's bit
+// and pairs across children XOR at or above it, so a node's best pair comes
+// from a child unless both children hold exactly one value, in which case it
+// is that single cross pair (the two sorted neighbours). Every node caches its
+// best pair and one representative value, Insert and Erase recompute the
+// cache along their path in O(kNumBits), and MinPairXor reads the root in
+// O(1). Pair XORs do not depend on the global XOR mask, so XorAll is O(1).
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class MinPairXorTrie {
+  static_assert(kNumBits > 0, "MinPairXorTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "MinPairXorTrie bit width exceeds ValueType digits");
+
+ public:
+  MinPairXorTrie() : nodes_(1) {}
+
+  MinPairXorTrie(const MinPairXorTrie&) = delete;
+  MinPairXorTrie& operator=(const MinPairXorTrie&) = delete;
+  MinPairXorTrie(MinPairXorTrie&&) = delete;
+  MinPairXorTrie& operator=(MinPairXorTrie&&) = delete;
+
+  // Inserts `count` copies of `value`. O(kNumBits).
+  void Insert(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    if (count == 0) {
+      return;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    std::array<int, kNumBits + 1> path{};
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const int direction =
+          static_cast<int>((stored >> (kNumBits - 1 - depth)) & 1);
+      int child_index = nodes_[path[depth]].children[direction];
+      if (child_index == kNull) {
+        child_index = NewNode();
+        nodes_[path[depth]].children[direction] = child_index;
+      }
+      path[depth + 1] = child_index;
+    }
+    Node& leaf = nodes_[path[kNumBits]];
+    leaf.count += count;
+    leaf.representative = stored;
+    leaf.has_pair = leaf.count >= 2;
+    leaf.best = 0;
+    for (int depth = kNumBits - 1; depth >= 0; --depth) {
+      Pull(path[depth]);
+    }
+  }
+
+  // Removes up to `count` copies of `value`. O(kNumBits).
+  void Erase(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    if (count == 0) {
+      return;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    std::array<int, kNumBits + 1> path{};
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const int direction =
+          static_cast<int>((stored >> (kNumBits - 1 - depth)) & 1);
+      path[depth + 1] = nodes_[path[depth]].children[direction];
+      if (path[depth + 1] == kNull) {
+        return;
+      }
+    }
+    Node& leaf = nodes_[path[kNumBits]];
+    leaf.count -= std::min(count, leaf.count);
+    leaf.has_pair = leaf.count >= 2;
+    for (int depth = kNumBits - 1; depth >= 0; --depth) {
+      const int direction =
+          static_cast<int>((stored >> (kNumBits - 1 - depth)) & 1);
+      if (nodes_[path[depth + 1]].count == 0) {
+        nodes_[path[depth]].children[direction] = kNull;
+        free_list_.push_back(path[depth + 1]);
+      }
+      Pull(path[depth]);
+    }
+  }
+
+  // Returns the multiplicity of `value`. O(kNumBits).
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const ValueType stored = value ^ xor_mask_;
+    int node_index = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      node_index =
+          nodes_[node_index].children[static_cast<int>((stored >> bit) & 1)];
+      if (node_index == kNull) {
+        return static_cast<CountType>(0);
+      }
+    }
+    return nodes_[node_index].count;
+  }
+
+  // Total multiplicity stored. O(1).
+  [[nodiscard]] CountType TotalCount() const { return nodes_[0].count; }
+
+  // Returns min(a_i XOR a_j) over pairs of distinct elements (equal values
+  // stored twice give 0), or nullopt with fewer than two elements. O(1).
+  [[nodiscard]] std::optional<ValueType> MinPairXor() const {
+    if (!nodes_[0].has_pair) {
+      return std::nullopt;
+    }
+    return nodes_[0].best;
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(1).
+  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+
+  // Heap bytes currently reserved by the node pool and free list. O(1).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return nodes_.capacity() * sizeof(Node) +
+           free_list_.capacity() * sizeof(int);
+  }
+
+ private:
+  static constexpr int kNull = -1;
+
+  struct Node {
+    std::array<int, 2> children{{kNull, kNull}};
+    CountType count{0};
+    // Some stored value of the subtree; the only one when count == 1.
+    ValueType representative{0};
+    // Minimum pair XOR within the subtree, valid when has_pair.
+    ValueType best{0};
+    bool has_pair{false};
+  };
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Recomputes an internal node's cache from its children.
+  void Pull(int node_index) {
+    const int zero = nodes_[node_index].children[0];
+    const int one = nodes_[node_index].children[1];
+    Node& node = nodes_[node_index];
+    node.count = 0;
+    node.has_pair = false;
+    for (const int child_index : {zero, one}) {
+      if (child_index == kNull) {
+        continue;
+      }
+      const Node& child = nodes_[child_index];
+      node.count += child.count;
+      node.representative = child.representative;
+      if (child.has_pair) {
+        node.best = node.has_pair ? std::min(node.best, child.best)
+                                  : child.best;
+        node.has_pair = true;
+      }
+    }
+    if (!node.has_pair && zero != kNull && one != kNull) {
+      node.best = static_cast<ValueType>(nodes_[zero].representative ^
+                                         nodes_[one].representative);
+      node.has_pair = true;
+    }
+  }
+
+  int NewNode() {
+    if (!free_list_.empty()) {
+      const int idx = free_list_.back();
+      free_list_.pop_back();
+      nodes_[idx] = Node{};
+      return idx;
+    }
+    nodes_.emplace_back();
+    return static_cast<int>(nodes_.size() - 1);
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<int> free_list_;
+  ValueType xor_mask_{0};
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_MIN_PAIR_XOR_TRIE_H_
@@ -0,0 +1,47 @@
+#include "hotaosa/ds/min_pair_xor_trie.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(MinPairXorTrieTest, TracksMinimumUnderUpdates) {
+  MinPairXorTrie<std::uint32_t, 8> trie;
+  EXPECT_FALSE(trie.MinPairXor().has_value());
+  trie.Insert(0b1000'0000);
+  EXPECT_FALSE(trie.MinPairXor().has_value());
+  trie.Insert(0b0000'0001);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0b1000'0001));
+  trie.Insert(0b1000'0110);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0b110));
+  trie.Insert(0b0000'0011);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0b10));
+
+  trie.Insert(0b1000'0110);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0));
+  trie.Erase(0b1000'0110);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0b10));
+
+  trie.Erase(0b0000'0011);
+  trie.Erase(0b0000'0001);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint32_t>(0b110));
+  EXPECT_EQ(trie.TotalCount(), 2);
+}
+
+TEST(MinPairXorTrieTest, XorAllKeepsPairXors) {
+  MinPairXorTrie<std::uint64_t> trie;
+  trie.Insert(100);
+  trie.Insert(1000);
+  trie.Insert(1003);
+  trie.XorAll(0xFFFF);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint64_t>(3));
+  EXPECT_EQ(trie.Count(1000 ^ 0xFFFF), 1);
+  trie.Erase(1003 ^ 0xFFFF);
+  EXPECT_EQ(trie.MinPairXor(), std::optional<std::uint64_t>(100 ^ 1000));
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,296 @@
+#ifndef HOTAOSA_DS_PACKED_BINARY_TRIE_H_
+#define HOTAOSA_DS_PACKED_BINARY_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace hotaosa {
+
+// PackedBinaryTrie is a BinaryTrie with a compact node layout. Siblings are
+// allocated as one pair, so a node stores a single 32-bit link to its
+// children and a single count, and both branches of a decision arrive in the
+// same cache line; an absent child is a zero count in its slot. The last
+// level keeps bare multiplicities in a separate array of count pairs, so
+// leaves cost one CountType each. Nodes take 8 bytes instead of BinaryTrie's
+// 16-24, at the price of BinaryTrie's per-node tags and sums: only the global
+// XorAll mask is supported. Pairs emptied by Erase are recycled.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class PackedBinaryTrie {
+  static_assert(kNumBits > 0, "PackedBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "PackedBinaryTrie bit width exceeds ValueType digits");
+
+ public:
+  PackedBinaryTrie() : pairs_(1), leaf_pairs_(1) {}
+
+  PackedBinaryTrie(const PackedBinaryTrie&) = delete;
+  PackedBinaryTrie& operator=(const PackedBinaryTrie&) = delete;
+  PackedBinaryTrie(PackedBinaryTrie&&) = delete;
+  PackedBinaryTrie& operator=(PackedBinaryTrie&&) = delete;
+
+  // Inserts `count` copies of `value`. O(kNumBits).
+  void Insert(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    if (count == 0) {
+      return;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      pairs_[pair][slot].count += count;
+      const int direction = StoredBit(stored, depth);
+      Index children = pairs_[pair][slot].children;
+      if (depth + 1 == kNumBits) {
+        if (children == kNone) {
+          children = NewPair(leaf_pairs_, free_leaf_pairs_);
+          pairs_[pair][slot].children = children;
+        }
+        leaf_pairs_[children][direction] += count;
+        return;
+      }
+      if (children == kNone) {
+        children = NewPair(pairs_, free_pairs_);
+        pairs_[pair][slot].children = children;
+      }
+      pair = children;
+      slot = direction;
+    }
+  }
+
+  // Removes up to `count` copies of `value`. O(kNumBits).
+  void Erase(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    const CountType removable = std::min(count, Count(value));
+    if (removable == 0) {
+      return;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      Node& node = pairs_[pair][slot];
+      const Index children = node.children;
+      const int direction = StoredBit(stored, depth);
+      node.count -= removable;
+      // An emptied node drops its child pair; the walk may still pass
+      // through it because released pairs are only reset on reuse.
+      const bool emptied = node.count == 0;
+      if (emptied) {
+        node.children = kNone;
+      }
+      if (depth + 1 == kNumBits) {
+        leaf_pairs_[children][direction] -= removable;
+        if (emptied) {
+          free_leaf_pairs_.push_back(children);
+        }
+        return;
+      }
+      if (emptied) {
+        free_pairs_.push_back(children);
+      }
+      pair = children;
+      slot = direction;
+    }
+  }
+
+  // Returns the multiplicity of `value`. O(kNumBits).
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const ValueType stored = value ^ xor_mask_;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth + 1 < kNumBits; ++depth) {
+      const Node& node = pairs_[pair][slot];
+      if (node.count == 0) {
+        return static_cast<CountType>(0);
+      }
+      pair = node.children;
+      slot = StoredBit(stored, depth);
+    }
+    const Node& last = pairs_[pair][slot];
+    if (last.count == 0) {
+      return static_cast<CountType>(0);
+    }
+    return leaf_pairs_[last.children][StoredBit(stored, kNumBits - 1)];
+  }
+
+  // Total multiplicity stored. O(1).
+  [[nodiscard]] CountType TotalCount() const { return pairs_[0][0].count; }
+
+  // Returns how many stored values are strictly less than `value`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    CountType result = 0;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const Node& node = pairs_[pair][slot];
+      if (node.count == 0) {
+        return result;
+      }
+      const int mask_bit = StoredBit(xor_mask_, depth);
+      const int actual_bit = StoredBit(value, depth);
+      const std::array<CountType, 2> counts = ChildCounts(node, depth);
+      if (actual_bit == 1) {
+        result += counts[mask_bit];
+      }
+      if (depth + 1 == kNumBits) {
+        return result;
+      }
+      pair = node.children;
+      slot = actual_bit ^ mask_bit;
+    }
+    return result;
+  }
+
+  // Returns the k-th smallest value (0-indexed). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    if (k < 0 || k >= TotalCount()) {
+      return std::nullopt;
+    }
+    ValueType result = 0;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const Node& node = pairs_[pair][slot];
+      const int mask_bit = StoredBit(xor_mask_, depth);
+      const CountType zero_count = ChildCounts(node, depth)[mask_bit];
+      int direction = mask_bit;
+      if (k >= zero_count) {
+        k -= zero_count;
+        direction ^= 1;
+        result |= ValueType{1} << (kNumBits - 1 - depth);
+      }
+      pair = node.children;
+      slot = direction;
+    }
+    return result;
+  }
+
+  // Returns the maximum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(ValueType value) const {
+    return FindExtremeXor(value, true);
+  }
+
+  // Returns the minimum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(ValueType value) const {
+    return FindExtremeXor(value, false);
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(1).
+  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+
+  // Heap bytes currently reserved by the pair pools and free lists. O(1).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return pairs_.capacity() * sizeof(NodePair) +
+           leaf_pairs_.capacity() * sizeof(LeafPair) +
+           (free_pairs_.capacity() + free_leaf_pairs_.capacity()) *
+               sizeof(Index);
+  }
+
+ private:
+  using Index = std::uint32_t;
+
+  // Pair 0 of either pool is never a child pair: pairs_[0][0] is the root
+  // and leaf_pairs_[0] is padding, so 0 doubles as "no children".
+  static constexpr Index kNone = 0;
+
+  struct Node {
+    // Index of the child pair in pairs_, or in leaf_pairs_ on the last
+    // internal level.
+    Index children{kNone};
+    CountType count{0};
+  };
+  using NodePair = std::array<Node, 2>;
+  using LeafPair = std::array<CountType, 2>;
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Bit of `value` that nodes at `depth` branch on.
+  [[nodiscard]] static int StoredBit(ValueType value, int depth) {
+    return static_cast<int>((value >> (kNumBits - 1 - depth)) & 1);
+  }
+
+  // Counts of both stored children of `node`, which sits at `depth`.
+  [[nodiscard]] std::array<CountType, 2> ChildCounts(const Node& node,
+                                                     int depth) const {
+    if (node.children == kNone) {
+      return {0, 0};
+    }
+    if (depth + 1 == kNumBits) {
+      return leaf_pairs_[node.children];
+    }
+    const NodePair& children = pairs_[node.children];
+    return {children[0].count, children[1].count};
+  }
+
+  // Returns (best element XOR `value`) for the largest or smallest XOR.
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(ValueType value,
+                                                        bool maximize) const {
+    assert((value & ~BitMask()) == 0);
+    if (TotalCount() <= 0) {
+      return std::nullopt;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    ValueType result = 0;
+    Index pair = 0;
+    int slot = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const Node& node = pairs_[pair][slot];
+      // The stored direction opposite to `stored` sets the XOR bit.
+      const int one_direction = StoredBit(stored, depth) ^ 1;
+      int direction = one_direction ^ static_cast<int>(!maximize);
+      if (ChildCounts(node, depth)[direction] == 0) {
+        direction ^= 1;
+      }
+      if (direction == one_direction) {
+        result |= ValueType{1} << (kNumBits - 1 - depth);
+      }
+      pair = node.children;
+      slot = direction;
+    }
+    return result;
+  }
+
+  template <typename Pair>
+  static Index NewPair(std::vector<Pair>& pool, std::vector<Index>& free) {
+    if (!free.empty()) {
+      const Index idx = free.back();
+      free.pop_back();
+      pool[idx] = Pair{};
+      return idx;
+    }
+    assert(pool.size() < std::numeric_limits<Index>::max());
+    pool.emplace_back();
+    return static_cast<Index>(pool.size() - 1);
+  }
+
+  std::vector<NodePair> pairs_;
+  std::vector<LeafPair> leaf_pairs_;
+  std::vector<Index> free_pairs_;
+  std::vector<Index> free_leaf_pairs_;
+  ValueType xor_mask_{0};
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_PACKED_BINARY_TRIE_H_
@@ -0,0 +1,55 @@
+#include "hotaosa/ds/packed_binary_trie.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(PackedBinaryTrieTest, InsertEraseAndOrderQueries) {
+  PackedBinaryTrie<std::uint32_t, 8> trie;
+  trie.Insert(1);
+  trie.Insert(3, 2);
+  trie.Insert(7);
+  trie.Insert(200);
+
+  EXPECT_EQ(trie.TotalCount(), 5);
+  EXPECT_EQ(trie.Count(3), 2);
+  EXPECT_EQ(trie.Count(2), 0);
+  EXPECT_EQ(trie.CountLess(7), 3);
+  EXPECT_EQ(trie.Kth(3), std::optional<std::uint32_t>(7));
+  EXPECT_EQ(trie.MaxXor(0), std::optional<std::uint32_t>(200));
+  EXPECT_EQ(trie.MinXor(6), std::optional<std::uint32_t>(1));
+
+  trie.Erase(3, 5);
+  trie.Erase(200);
+  EXPECT_EQ(trie.TotalCount(), 2);
+  EXPECT_EQ(trie.Kth(1), std::optional<std::uint32_t>(7));
+  EXPECT_EQ(trie.MaxXor(0), std::optional<std::uint32_t>(7));
+  EXPECT_FALSE(trie.Kth(2).has_value());
+}
+
+TEST(PackedBinaryTrieTest, XorAllAndReuseAfterEmptying) {
+  PackedBinaryTrie<std::uint64_t> trie;
+  trie.Insert(10);
+  trie.Insert(1ull << 63);
+  trie.XorAll(1ull << 63);  // {10 + 2^63, 0}
+  EXPECT_EQ(trie.Kth(0), std::optional<std::uint64_t>(0));
+  EXPECT_EQ(trie.CountLess(1ull << 63), 1);
+
+  trie.Erase(0);
+  trie.Erase(10 | (1ull << 63));
+  EXPECT_EQ(trie.TotalCount(), 0);
+  EXPECT_FALSE(trie.MinXor(5).has_value());
+  const std::size_t memory = trie.MemoryUsage();
+  trie.Insert(42);
+  trie.Erase(42);
+  trie.Insert(42);
+  EXPECT_EQ(trie.MemoryUsage(), memory);
+  EXPECT_EQ(trie.MinXor(40), std::optional<std::uint64_t>(2));
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,398 @@
+#ifndef HOTAOSA_DS_PATRICIA_BINARY_TRIE_H_
+#define HOTAOSA_DS_PATRICIA_BINARY_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace hotaosa {
+
+// PatriciaBinaryTrie is a path-compressed counterpart of BinaryTrie: only
+// branching points are materialised, so N distinct values occupy at most
+// 2N - 1 nodes independent of kNumBits. Each node remembers the bit it
+// branches on together with one stored key of its subtree, which supplies the
+// skipped prefix bits. The query API and the lazy XOR mask match BinaryTrie;
+// every operation walks at most kNumBits + 1 nodes.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class PatriciaBinaryTrie {
+  static_assert(kNumBits > 0, "PatriciaBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "PatriciaBinaryTrie bit width exceeds ValueType digits");
+
+ public:
+  PatriciaBinaryTrie() = default;
+
+  PatriciaBinaryTrie(const PatriciaBinaryTrie&) = delete;
+  PatriciaBinaryTrie& operator=(const PatriciaBinaryTrie&) = delete;
+  PatriciaBinaryTrie(PatriciaBinaryTrie&&) = delete;
+  PatriciaBinaryTrie& operator=(PatriciaBinaryTrie&&) = delete;
+
+  // Inserts one copy of `value`. O(kNumBits).
+  void Insert(ValueType value) { Insert(value, static_cast<CountType>(1)); }
+
+  // Inserts `count` copies of `value`. O(kNumBits).
+  void Insert(ValueType value, CountType count) {
+    assert(count >= 0);
+    if (count == 0) {
+      return;
+    }
+    assert((value & ~BitMask()) == 0);
+    const ValueType stored_value = ToStored(value);
+    if (root_ == kNull) {
+      root_ = NewNode(stored_value, kLeafBit, count);
+      return;
+    }
+    int node_index = root_;
+    while (nodes_[node_index].bit != kLeafBit) {
+      node_index = StoredChild(node_index, stored_value);
+    }
+    const ValueType difference = nodes_[node_index].key ^ stored_value;
+    const int split_bit =
+        difference == 0 ? kLeafBit : std::bit_width(difference) - 1;
+    int parent = kNull;
+    node_index = root_;
+    while (nodes_[node_index].bit > split_bit) {
+      nodes_[node_index].count += count;
+      parent = node_index;
+      node_index = StoredChild(node_index, stored_value);
+    }
+    if (split_bit == kLeafBit) {
+      nodes_[node_index].count += count;
+      return;
+    }
+    const int leaf = NewNode(stored_value, kLeafBit, count);
+    const int branch =
+        NewNode(stored_value, split_bit, nodes_[node_index].count + count);
+    const int direction = static_cast<int>((stored_value >> split_bit) & 1);
+    nodes_[branch].children[direction] = leaf;
+    nodes_[branch].children[direction ^ 1] = node_index;
+    Relink(parent, stored_value, branch);
+  }
+
+  // Removes one copy of `value` when present. O(kNumBits).
+  void Erase(ValueType value) { Erase(value, static_cast<CountType>(1)); }
+
+  // Removes up to `count` copies of `value`. O(kNumBits).
+  void Erase(ValueType value, CountType count) {
+    assert(count >= 0);
+    if (count == 0 || root_ == kNull) {
+      return;
+    }
+    assert((value & ~BitMask()) == 0);
+    const ValueType stored_value = ToStored(value);
+    std::array<int, kNumBits + 1> path{};
+    int depth = 0;
+    int node_index = root_;
+    path[depth++] = node_index;
+    while (nodes_[node_index].bit != kLeafBit) {
+      node_index = StoredChild(node_index, stored_value);
+      path[depth++] = node_index;
+    }
+    if (nodes_[node_index].key != stored_value) {
+      return;
+    }
+    const CountType removable = std::min(count, nodes_[node_index].count);
+    for (int i = 0; i < depth; ++i) {
+      nodes_[path[i]].count -= removable;
+    }
+    if (nodes_[node_index].count > 0) {
+      return;
+    }
+    free_list_.push_back(node_index);
+    if (depth == 1) {
+      root_ = kNull;
+      return;
+    }
+    // Splice out the emptied leaf's parent by promoting the sibling.
+    const int parent = path[depth - 2];
+    const int direction =
+        static_cast<int>((stored_value >> nodes_[parent].bit) & 1);
+    const int sibling = nodes_[parent].children[direction ^ 1];
+    free_list_.push_back(parent);
+    Relink(depth >= 3 ? path[depth - 3] : kNull, stored_value, sibling);
+  }
+
+  // Returns the multiplicity of `value` stored in the trie. O(kNumBits).
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    if (root_ == kNull) {
+      return static_cast<CountType>(0);
+    }
+    const ValueType stored_value = ToStored(value);
+    int node_index = root_;
+    while (nodes_[node_index].bit != kLeafBit) {
+      node_index = StoredChild(node_index, stored_value);
+    }
+    return nodes_[node_index].key == stored_value ? nodes_[node_index].count
+                                                  : static_cast<CountType>(0);
+  }
+
+  // Total multiplicity stored in the trie. O(1).
+  [[nodiscard]] CountType TotalCount() const {
+    return root_ == kNull ? static_cast<CountType>(0) : nodes_[root_].count;
+  }
+
+  // Returns whether the multiset currently contains `value`. O(kNumBits).
+  [[nodiscard]] bool Contains(ValueType value) const {
+    return Count(value) > static_cast<CountType>(0);
+  }
+
+  // Returns how many stored values are strictly less than `value`. O(kNumBits).
+  [[nodiscard]] CountType CountLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    CountType result = 0;
+    int node_index = root_;
+    while (node_index != kNull) {
+      const Node& node = nodes_[node_index];
+      const ValueType difference =
+          HighBits(ToActual(node.key) ^ value, node.bit + 1);
+      if (difference != 0) {
+        const int top_bit = std::bit_width(difference) - 1;
+        if (((value >> top_bit) & 1) == 1) {
+          result += node.count;
+        }
+        break;
+      }
+      if (node.bit == kLeafBit) {
+        break;
+      }
+      const int actual_bit = static_cast<int>((value >> node.bit) & 1);
+      if (actual_bit == 1) {
+        result += nodes_[ActualChild(node_index, 0)].count;
+      }
+      node_index = ActualChild(node_index, actual_bit);
+    }
+    return result;
+  }
+
+  // Returns how many stored values are strictly greater than `value`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountGreater(ValueType value) const {
+    return static_cast<CountType>(TotalCount() - CountLess(value) -
+                                  Count(value));
+  }
+
+  // Returns the k-th smallest value (0-indexed). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    if (k < 0 || k >= TotalCount()) {
+      return std::nullopt;
+    }
+    int node_index = root_;
+    while (nodes_[node_index].bit != kLeafBit) {
+      const int zero_child = ActualChild(node_index, 0);
+      if (k < nodes_[zero_child].count) {
+        node_index = zero_child;
+      } else {
+        k -= nodes_[zero_child].count;
+        node_index = ActualChild(node_index, 1);
+      }
+    }
+    return ToActual(nodes_[node_index].key);
+  }
+
+  // Returns minimal value >= `value`. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> LowerBound(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/true, /*inclusive=*/true);
+  }
+
+  // Returns minimal value > `value`. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> UpperBound(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/true, /*inclusive=*/false);
+  }
+
+  // Returns maximal value <= `value`. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Prev(ValueType value) const {
+    return FindNeighbor(value, /*upward=*/false, /*inclusive=*/true);
+  }
+
+  // Returns the smallest stored value. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Min() const {
+    if (root_ == kNull) {
+      return std::nullopt;
+    }
+    return Extreme(root_, false);
+  }
+
+  // Returns the largest stored value. O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Max() const {
+    if (root_ == kNull) {
+      return std::nullopt;
+    }
+    return Extreme(root_, true);
+  }
+
+  // Returns the maximum value of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(ValueType value) const {
+    return FindExtremeXor(value, true);
+  }
+
+  // Returns the minimum value of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(ValueType value) const {
+    return FindExtremeXor(value, false);
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(1).
+  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+
+  // Heap bytes currently reserved by the node pool and free list. O(1).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return nodes_.capacity() * sizeof(Node) +
+           free_list_.capacity() * sizeof(int);
+  }
+
+ private:
+  static constexpr int kNull = -1;
+  static constexpr int kLeafBit = -1;
+
+  struct Node {
+    ValueType key{0};
+    int bit{kLeafBit};
+    std::array<int, 2> children{{kNull, kNull}};
+    CountType count{0};
+  };
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Keeps the bits of `value` at positions >= `low_bit`.
+  [[nodiscard]] static constexpr ValueType HighBits(ValueType value,
+                                                    int low_bit) {
+    if (low_bit >= kNumBits) {
+      return 0;
+    }
+    return static_cast<ValueType>((value >> low_bit) << low_bit);
+  }
+
+  [[nodiscard]] ValueType ToStored(ValueType value) const {
+    return (value ^ xor_mask_) & BitMask();
+  }
+
+  [[nodiscard]] ValueType ToActual(ValueType stored) const {
+    return (stored ^ xor_mask_) & BitMask();
+  }
+
+  [[nodiscard]] int StoredChild(int node_index, ValueType stored_value) const {
+    const Node& node = nodes_[node_index];
+    return node.children[(stored_value >> node.bit) & 1];
+  }
+
+  [[nodiscard]] int ActualChild(int node_index, int actual_bit) const {
+    const Node& node = nodes_[node_index];
+    return node.children[actual_bit ^
+                         static_cast<int>((xor_mask_ >> node.bit) & 1)];
+  }
+
+  // Points the link that led to the replaced subtree (the root or the child
+  // of `parent` on the side of `stored_value`) at `node_index`.
+  void Relink(int parent, ValueType stored_value, int node_index) {
+    if (parent == kNull) {
+      root_ = node_index;
+      return;
+    }
+    const int direction =
+        static_cast<int>((stored_value >> nodes_[parent].bit) & 1);
+    nodes_[parent].children[direction] = node_index;
+  }
+
+  [[nodiscard]] ValueType Extreme(int node_index, bool maximize) const {
+    while (nodes_[node_index].bit != kLeafBit) {
+      node_index = ActualChild(node_index, static_cast<int>(maximize));
+    }
+    return ToActual(nodes_[node_index].key);
+  }
+
+  // Single descent remembering the deepest sibling subtree on the requested
+  // side; a prefix mismatch settles the answer at once because every value in
+  // a subtree shares its skipped bits.
+  [[nodiscard]] std::optional<ValueType> FindNeighbor(ValueType value,
+                                                      bool upward,
+                                                      bool inclusive) const {
+    assert((value & ~BitMask()) == 0);
+    const int toward = static_cast<int>(upward);
+    int branch = kNull;
+    int node_index = root_;
+    while (node_index != kNull) {
+      const Node& node = nodes_[node_index];
+      const ValueType difference =
+          HighBits(ToActual(node.key) ^ value, node.bit + 1);
+      if (difference != 0) {
+        const int top_bit = std::bit_width(difference) - 1;
+        const int subtree_bit = static_cast<int>((value >> top_bit) & 1) ^ 1;
+        if (subtree_bit == toward) {
+          return Extreme(node_index, !upward);
+        }
+        break;
+      }
+      if (node.bit == kLeafBit) {
+        if (inclusive) {
+          return value;
+        }
+        break;
+      }
+      const int actual_bit = static_cast<int>((value >> node.bit) & 1);
+      if (actual_bit != toward) {
+        branch = ActualChild(node_index, toward);
+      }
+      node_index = ActualChild(node_index, actual_bit);
+    }
+    if (branch == kNull) {
+      return std::nullopt;
+    }
+    return Extreme(branch, !upward);
+  }
+
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(ValueType value,
+                                                        bool maximize) const {
+    assert((value & ~BitMask()) == 0);
+    if (root_ == kNull) {
+      return std::nullopt;
+    }
+    int node_index = root_;
+    while (nodes_[node_index].bit != kLeafBit) {
+      const int value_bit =
+          static_cast<int>((value >> nodes_[node_index].bit) & 1);
+      node_index =
+          ActualChild(node_index, value_bit ^ static_cast<int>(maximize));
+    }
+    return (ToActual(nodes_[node_index].key) ^ value) & BitMask();
+  }
+
+  int NewNode(ValueType key, int bit, CountType count) {
+    int idx;
+    if (!free_list_.empty()) {
+      idx = free_list_.back();
+      free_list_.pop_back();
+      nodes_[idx] = Node{};
+    } else {
+      nodes_.emplace_back();
+      idx = static_cast<int>(nodes_.size() - 1);
+    }
+    nodes_[idx].key = key;
+    nodes_[idx].bit = bit;
+    nodes_[idx].count = count;
+    return idx;
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<int> free_list_;
+  int root_{kNull};
+  ValueType xor_mask_{0};
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_PATRICIA_BINARY_TRIE_H_
@@ -0,0 +1,89 @@
+#include "hotaosa/ds/patricia_binary_trie.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(PatriciaBinaryTrieTest, InsertEraseAndCount) {
+  PatriciaBinaryTrie<std::uint64_t> trie;
+  EXPECT_EQ(trie.TotalCount(), 0);
+
+  trie.Insert(5);
+  trie.Insert(0);
+  trie.Insert(5);
+  trie.Insert(0xFFFF'FFFF'FFFF'FFFFull);
+
+  EXPECT_EQ(trie.TotalCount(), 4);
+  EXPECT_EQ(trie.Count(5), 2);
+  EXPECT_EQ(trie.Count(0), 1);
+  EXPECT_TRUE(trie.Contains(0xFFFF'FFFF'FFFF'FFFFull));
+  EXPECT_FALSE(trie.Contains(4));
+
+  trie.Erase(5, 10);
+  EXPECT_EQ(trie.Count(5), 0);
+  EXPECT_EQ(trie.TotalCount(), 2);
+
+  trie.Erase(123);  // missing key, no-op
+  EXPECT_EQ(trie.TotalCount(), 2);
+
+  trie.Erase(0);
+  trie.Erase(0xFFFF'FFFF'FFFF'FFFFull);
+  EXPECT_EQ(trie.TotalCount(), 0);
+  EXPECT_FALSE(trie.Min().has_value());
+}
+
+TEST(PatriciaBinaryTrieTest, OrderQueries) {
+  PatriciaBinaryTrie<std::uint16_t, 10> trie;
+  trie.Insert(12);
+  trie.Insert(20, 2);
+  trie.Insert(31);
+
+  EXPECT_EQ(trie.CountLess(12), 0);
+  EXPECT_EQ(trie.CountLess(21), 3);
+  EXPECT_EQ(trie.CountGreater(12), 3);
+  EXPECT_EQ(trie.Kth(0), std::optional<std::uint16_t>(12));
+  EXPECT_EQ(trie.Kth(2), std::optional<std::uint16_t>(20));
+  EXPECT_EQ(trie.Kth(3), std::optional<std::uint16_t>(31));
+  EXPECT_FALSE(trie.Kth(4).has_value());
+
+  EXPECT_EQ(trie.LowerBound(13), std::optional<std::uint16_t>(20));
+  EXPECT_EQ(trie.UpperBound(20), std::optional<std::uint16_t>(31));
+  EXPECT_FALSE(trie.LowerBound(32).has_value());
+  EXPECT_EQ(trie.Prev(19), std::optional<std::uint16_t>(12));
+  EXPECT_FALSE(trie.Prev(11).has_value());
+}
+
+TEST(PatriciaBinaryTrieTest, XorQueriesAndMask) {
+  PatriciaBinaryTrie<std::uint16_t, 8> trie;
+  trie.Insert(1);
+  trie.Insert(6);
+
+  EXPECT_EQ(trie.MaxXor(6), std::optional<std::uint16_t>(6 ^ 1));
+  EXPECT_EQ(trie.MinXor(6), std::optional<std::uint16_t>(0));
+
+  trie.XorAll(3);  // {1,6} -> {2,5}
+  EXPECT_TRUE(trie.Contains(2));
+  EXPECT_TRUE(trie.Contains(5));
+  EXPECT_FALSE(trie.Contains(1));
+  EXPECT_EQ(trie.CountLess(5), 1);
+  EXPECT_EQ(trie.Min(), std::optional<std::uint16_t>(2));
+  EXPECT_EQ(trie.Max(), std::optional<std::uint16_t>(5));
+  EXPECT_EQ(trie.MaxXor(1), std::optional<std::uint16_t>(1 ^ 5));
+}
+
+TEST(PatriciaBinaryTrieTest, NodeCountIsIndependentOfWidth) {
+  PatriciaBinaryTrie<std::uint64_t> trie;
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    trie.Insert(i * 0x9E37'79B9'7F4A'7C15ull);
+  }
+  // At most 2N - 1 nodes of at most 32 bytes each, plus vector slack.
+  EXPECT_LE(trie.MemoryUsage(), std::size_t{2} * 2000 * 32);
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,219 @@
+#ifndef HOTAOSA_DS_PERSISTENT_BINARY_TRIE_H_
+#define HOTAOSA_DS_PERSISTENT_BINARY_TRIE_H_
+
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace hotaosa {
+
+// PersistentBinaryTrie is a path-copying BinaryTrie: every Insert leaves the
+// base version intact and returns a handle to a new one. Inserting a[0..N)
+// one by one yields versions v[0..N], and the pair (v[l], v[r]) describes the
+// multiset {a[l], ..., a[r - 1]}: range queries walk both versions in lockstep
+// and use count differences. Node 0 is a shared empty sentinel whose children
+// point back to itself, so lockstep walks never test for missing children.
+// Nodes come from one contiguous pool that can be sized upfront.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class PersistentBinaryTrie {
+  static_assert(kNumBits > 0, "PersistentBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "PersistentBinaryTrie bit width exceeds ValueType digits");
+
+ public:
+  using Version = int;
+
+  // Version holding no values; always valid.
+  static constexpr Version kEmptyVersion = 0;
+
+  // Reserves the pool for `max_insertions` Insert calls, i.e.
+  // max_insertions * (kNumBits + 1) nodes.
+  explicit PersistentBinaryTrie(int max_insertions = 0) : nodes_(1), roots_(1) {
+    assert(max_insertions >= 0);
+    nodes_.reserve(1 + static_cast<std::size_t>(max_insertions) *
+                           (kNumBits + 1));
+    roots_.reserve(1 + static_cast<std::size_t>(max_insertions));
+  }
+
+  PersistentBinaryTrie(const PersistentBinaryTrie&) = delete;
+  PersistentBinaryTrie& operator=(const PersistentBinaryTrie&) = delete;
+  PersistentBinaryTrie(PersistentBinaryTrie&&) = delete;
+  PersistentBinaryTrie& operator=(PersistentBinaryTrie&&) = delete;
+
+  // Returns a new version equal to `base` plus `count` copies of `value`.
+  // O(kNumBits) time and nodes.
+  Version Insert(Version base, ValueType value, CountType count = 1) {
+    assert(IsValidVersion(base));
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    int source = roots_[base];
+    const int root = CloneNode(source, count);
+    int node_index = root;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int direction = static_cast<int>((value >> bit) & 1);
+      source = nodes_[source].children[direction];
+      const int child_index = CloneNode(source, count);
+      nodes_[node_index].children[direction] = child_index;
+      node_index = child_index;
+    }
+    roots_.push_back(root);
+    return static_cast<Version>(roots_.size() - 1);
+  }
+
+  // Number of versions created so far, including kEmptyVersion. O(1).
+  [[nodiscard]] int NumVersions() const {
+    return static_cast<int>(roots_.size());
+  }
+
+  // Total multiplicity in `hi` minus `lo`. O(1).
+  [[nodiscard]] CountType TotalCount(Version lo, Version hi) const {
+    assert(IsValidVersion(lo) && IsValidVersion(hi));
+    return nodes_[roots_[hi]].count - nodes_[roots_[lo]].count;
+  }
+
+  // Multiplicity of `value` in `hi` minus `lo`. O(kNumBits).
+  [[nodiscard]] CountType Count(Version lo,
+                                Version hi,
+                                ValueType value) const {
+    assert(IsValidVersion(lo) && IsValidVersion(hi));
+    assert((value & ~BitMask()) == 0);
+    int lo_node = roots_[lo];
+    int hi_node = roots_[hi];
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int direction = static_cast<int>((value >> bit) & 1);
+      lo_node = nodes_[lo_node].children[direction];
+      hi_node = nodes_[hi_node].children[direction];
+    }
+    return nodes_[hi_node].count - nodes_[lo_node].count;
+  }
+
+  // Number of values strictly less than `value` in `hi` minus `lo`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountLess(Version lo,
+                                    Version hi,
+                                    ValueType value) const {
+    assert(IsValidVersion(lo) && IsValidVersion(hi));
+    assert((value & ~BitMask()) == 0);
+    CountType result = 0;
+    int lo_node = roots_[lo];
+    int hi_node = roots_[hi];
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const int direction = static_cast<int>((value >> bit) & 1);
+      if (direction == 1) {
+        result += nodes_[nodes_[hi_node].children[0]].count -
+                  nodes_[nodes_[lo_node].children[0]].count;
+      }
+      lo_node = nodes_[lo_node].children[direction];
+      hi_node = nodes_[hi_node].children[direction];
+    }
+    return result;
+  }
+
+  // Returns the k-th smallest value (0-indexed) of `hi` minus `lo`.
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(Version lo,
+                                             Version hi,
+                                             CountType k) const {
+    if (k < 0 || k >= TotalCount(lo, hi)) {
+      return std::nullopt;
+    }
+    int lo_node = roots_[lo];
+    int hi_node = roots_[hi];
+    ValueType result = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      const CountType zero_count = nodes_[nodes_[hi_node].children[0]].count -
+                                   nodes_[nodes_[lo_node].children[0]].count;
+      int direction = 0;
+      if (k >= zero_count) {
+        k -= zero_count;
+        direction = 1;
+        result |= (ValueType{1} << bit);
+      }
+      lo_node = nodes_[lo_node].children[direction];
+      hi_node = nodes_[hi_node].children[direction];
+    }
+    return result;
+  }
+
+  // Returns the maximum of (element XOR `value`) over `hi` minus `lo`.
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(Version lo,
+                                                Version hi,
+                                                ValueType value) const {
+    return FindExtremeXor(lo, hi, value, true);
+  }
+
+  // Returns the minimum of (element XOR `value`) over `hi` minus `lo`.
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(Version lo,
+                                                Version hi,
+                                                ValueType value) const {
+    return FindExtremeXor(lo, hi, value, false);
+  }
+
+ private:
+  struct Node {
+    std::array<int, 2> children{{0, 0}};
+    CountType count{0};
+  };
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  [[nodiscard]] bool IsValidVersion(Version version) const {
+    return 0 <= version && version < NumVersions();
+  }
+
+  int CloneNode(int source, CountType extra) {
+    Node node = nodes_[source];
+    node.count += extra;
+    nodes_.push_back(node);
+    return static_cast<int>(nodes_.size() - 1);
+  }
+
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(Version lo,
+                                                        Version hi,
+                                                        ValueType value,
+                                                        bool maximize) const {
+    assert((value & ~BitMask()) == 0);
+    if (TotalCount(lo, hi) <= 0) {
+      return std::nullopt;
+    }
+    int lo_node = roots_[lo];
+    int hi_node = roots_[hi];
+    ValueType result = 0;
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      int direction =
+          static_cast<int>((value >> bit) & 1) ^ static_cast<int>(maximize);
+      if (nodes_[nodes_[hi_node].children[direction]].count -
+              nodes_[nodes_[lo_node].children[direction]].count <=
+          0) {
+        direction ^= 1;
+      }
+      if (direction == 1) {
+        result |= (ValueType{1} << bit);
+      }
+      lo_node = nodes_[lo_node].children[direction];
+      hi_node = nodes_[hi_node].children[direction];
+    }
+    return (result ^ value) & BitMask();
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<int> roots_;
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_PERSISTENT_BINARY_TRIE_H_
@@ -0,0 +1,60 @@
+#include "hotaosa/ds/persistent_binary_trie.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(PersistentBinaryTrieTest, VersionsAreIndependent) {
+  PersistentBinaryTrie<std::uint32_t, 8> trie(3);
+  using Version = PersistentBinaryTrie<std::uint32_t, 8>::Version;
+  const Version empty = PersistentBinaryTrie<std::uint32_t, 8>::kEmptyVersion;
+  const Version one = trie.Insert(empty, 5);
+  const Version two = trie.Insert(one, 7, 2);
+  const Version branch = trie.Insert(one, 9);
+
+  EXPECT_EQ(trie.NumVersions(), 4);
+  EXPECT_EQ(trie.TotalCount(empty, one), 1);
+  EXPECT_EQ(trie.TotalCount(empty, two), 3);
+  EXPECT_EQ(trie.Count(empty, two, 7), 2);
+  EXPECT_EQ(trie.Count(empty, branch, 7), 0);
+  EXPECT_EQ(trie.Count(empty, branch, 9), 1);
+  EXPECT_EQ(trie.Count(one, two, 5), 0);
+}
+
+TEST(PersistentBinaryTrieTest, RangeQueriesOverArrayPrefixes) {
+  const std::vector<std::uint32_t> values = {3, 10, 5, 8, 1, 10};
+  PersistentBinaryTrie<std::uint32_t, 4> trie(static_cast<int>(values.size()));
+  std::vector<int> versions = {
+      PersistentBinaryTrie<std::uint32_t, 4>::kEmptyVersion};
+  for (const std::uint32_t value : values) {
+    versions.push_back(trie.Insert(versions.back(), value));
+  }
+
+  // Range [1, 4) holds {10, 5, 8}.
+  EXPECT_EQ(trie.MaxXor(versions[1], versions[4], 2),
+            std::optional<std::uint32_t>(2 ^ 8));
+  EXPECT_EQ(trie.MinXor(versions[1], versions[4], 9),
+            std::optional<std::uint32_t>(9 ^ 8));
+  EXPECT_EQ(trie.CountLess(versions[1], versions[4], 9), 2);
+  EXPECT_EQ(trie.Kth(versions[1], versions[4], 0),
+            std::optional<std::uint32_t>(5));
+  EXPECT_EQ(trie.Kth(versions[1], versions[4], 2),
+            std::optional<std::uint32_t>(10));
+  EXPECT_FALSE(trie.Kth(versions[1], versions[4], 3).has_value());
+
+  // Range [3, 6) holds {8, 1, 10}.
+  EXPECT_EQ(trie.Kth(versions[3], versions[6], 1),
+            std::optional<std::uint32_t>(8));
+  EXPECT_EQ(trie.MaxXor(versions[3], versions[6], 0),
+            std::optional<std::uint32_t>(10));
+
+  EXPECT_FALSE(trie.MaxXor(versions[2], versions[2], 0).has_value());
+}
+
+}  // namespace
+}  // namespace hotaosa
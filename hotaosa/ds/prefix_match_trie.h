@@ -0,0 +1,247 @@
+#ifndef HOTAOSA_DS_PREFIX_MATCH_TRIE_H_
+#define HOTAOSA_DS_PREFIX_MATCH_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hotaosa {
+
+// PrefixMatchTrie is a longest-prefix-match table: it stores bit prefixes of
+// explicit length with a payload each and maps a value to the payload of the
+// longest stored prefix it starts with, as in IPv4/IPv6 route lookup.
+//
+// Each node consumes kStrideBits bits of the value and has 2^kStrideBits
+// entries. With kStrideBits = 1 this is BinaryTrie's bitwise descent; a wider
+// stride cuts the lookup to kNumBits / kStrideBits node visits. A prefix whose
+// length is not a multiple of the stride is expanded over every entry it
+// covers in its last node, and an entry keeps the longest prefix expanded
+// onto it, so a lookup only remembers the last payload seen on its path. The
+// stored prefixes themselves are recorded separately, so replacing a prefix
+// finds it even when longer prefixes have overwritten all of its entries.
+template <std::unsigned_integral ValueType,
+          typename Payload,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          int kStrideBits = 1>
+class PrefixMatchTrie {
+  static_assert(kNumBits > 0, "PrefixMatchTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "PrefixMatchTrie bit width exceeds ValueType digits");
+  static_assert(0 < kStrideBits && kStrideBits <= 16,
+                "PrefixMatchTrie stride must be in [1, 16]");
+  static_assert(kNumBits % kStrideBits == 0,
+                "PrefixMatchTrie stride must divide the bit width");
+
+ public:
+  PrefixMatchTrie() : entries_(kFanout) {}
+
+  PrefixMatchTrie(const PrefixMatchTrie&) = delete;
+  PrefixMatchTrie& operator=(const PrefixMatchTrie&) = delete;
+  PrefixMatchTrie(PrefixMatchTrie&&) = delete;
+  PrefixMatchTrie& operator=(PrefixMatchTrie&&) = delete;
+
+  // Stores `payload` for the top `length` bits of `prefix`, replacing the
+  // payload of an equal prefix; the lower bits of `prefix` are ignored.
+  // Length 0 is the default route. O(kNumBits / kStrideBits +
+  // 2^kStrideBits) expected.
+  void Insert(ValueType prefix, int length, Payload payload) {
+    assert(0 <= length && length <= kNumBits);
+    assert((prefix & ~BitMask()) == 0);
+    if (length == 0) {
+      if (default_payload_ == kNull) {
+        default_payload_ = NewPayload(std::move(payload));
+      } else {
+        payloads_[default_payload_] = std::move(payload);
+      }
+      return;
+    }
+    const int last_level = (length - 1) / kStrideBits;
+    int node_index = 0;
+    for (int level = 0; level < last_level; ++level) {
+      const std::size_t entry = EntryIndex(node_index, Chunk(prefix, level));
+      if (entries_[entry].child == kNull) {
+        const int child = NewNode();
+        entries_[entry].child = child;
+      }
+      node_index = entries_[entry].child;
+    }
+    // The prefix covers the entries sharing its top `partial` chunk bits.
+    const int partial = length - last_level * kStrideBits;
+    const int free_bits = kStrideBits - partial;
+    const int first_chunk = (Chunk(prefix, last_level) >> free_bits)
+                            << free_bits;
+    const std::size_t first = EntryIndex(node_index, first_chunk);
+    const std::size_t last = first + (std::size_t{1} << free_bits);
+    const auto [stored, inserted] = stored_.try_emplace(
+        StoredKey(node_index, partial, first_chunk >> free_bits), kNull);
+    if (!inserted) {
+      payloads_[stored->second] = std::move(payload);
+      return;
+    }
+    const int payload_index = NewPayload(std::move(payload));
+    stored->second = payload_index;
+    for (std::size_t entry = first; entry < last; ++entry) {
+      if (entries_[entry].length < length) {
+        entries_[entry].payload = payload_index;
+        entries_[entry].length = length;
+      }
+    }
+  }
+
+  // Number of distinct prefixes stored, the default route included. O(1).
+  [[nodiscard]] int Size() const {
+    return static_cast<int>(payloads_.size());
+  }
+
+  // Returns the payload of the longest stored prefix of `value`.
+  // O(kNumBits / kStrideBits).
+  [[nodiscard]] std::optional<Payload> LongestPrefixMatch(
+      ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    int best = default_payload_;
+    int node_index = 0;
+    for (int level = 0; level < kLevels && node_index != kNull; ++level) {
+      const Entry& entry =
+          entries_[EntryIndex(node_index, Chunk(value, level))];
+      if (entry.payload != kNull) {
+        best = entry.payload;
+      }
+      node_index = entry.child;
+    }
+    if (best == kNull) {
+      return std::nullopt;
+    }
+    return payloads_[best];
+  }
+
+  // Answers LongestPrefixMatch for every element of `values`. Lookups
+  // advance together level by level in groups of kBatchLanes, prefetching
+  // each lane's next entry, so their cache misses overlap.
+  // O(|values| * kNumBits / kStrideBits).
+  [[nodiscard]] std::vector<std::optional<Payload>> LongestPrefixMatchBatch(
+      const std::vector<ValueType>& values) const {
+    std::vector<std::optional<Payload>> answers(values.size());
+    for (std::size_t begin = 0; begin < values.size(); begin += kBatchLanes) {
+      const int lanes = static_cast<int>(
+          std::min<std::size_t>(kBatchLanes, values.size() - begin));
+      std::array<int, kBatchLanes> node_indices;
+      std::array<int, kBatchLanes> best;
+      node_indices.fill(0);
+      best.fill(default_payload_);
+      for (int level = 0; level < kLevels; ++level) {
+        for (int lane = 0; lane < lanes; ++lane) {
+          if (node_indices[lane] == kNull) {
+            continue;
+          }
+          const ValueType value = values[begin + lane];
+          assert((value & ~BitMask()) == 0);
+          const Entry& entry =
+              entries_[EntryIndex(node_indices[lane], Chunk(value, level))];
+          if (entry.payload != kNull) {
+            best[lane] = entry.payload;
+          }
+          node_indices[lane] = entry.child;
+          if (entry.child != kNull && level + 1 < kLevels) {
+            Prefetch(EntryIndex(entry.child, Chunk(value, level + 1)));
+          }
+        }
+      }
+      for (int lane = 0; lane < lanes; ++lane) {
+        if (best[lane] != kNull) {
+          answers[begin + lane] = payloads_[best[lane]];
+        }
+      }
+    }
+    return answers;
+  }
+
+  // Heap bytes currently reserved by the entry and payload pools. O(1).
+  // The prefix map is not counted.
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return entries_.capacity() * sizeof(Entry) +
+           payloads_.capacity() * sizeof(Payload);
+  }
+
+ private:
+  static constexpr int kNull = -1;
+  static constexpr int kFanout = 1 << kStrideBits;
+  static constexpr int kLevels = kNumBits / kStrideBits;
+  // Independent lookups interleaved by LongestPrefixMatchBatch.
+  static constexpr int kBatchLanes = 16;
+
+  struct Entry {
+    int child{kNull};
+    // Index into payloads_ of the longest prefix covering this entry, whose
+    // length in bits is `length`; kNull and 0 when none.
+    int payload{kNull};
+    int length{0};
+  };
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // The kStrideBits bits of `value` consumed at `level`.
+  [[nodiscard]] static int Chunk(ValueType value, int level) {
+    return static_cast<int>((value >> (kNumBits - (level + 1) * kStrideBits)) &
+                            static_cast<ValueType>(kFanout - 1));
+  }
+
+  [[nodiscard]] static std::size_t EntryIndex(int node_index, int chunk) {
+    return static_cast<std::size_t>(node_index) * kFanout +
+           static_cast<std::size_t>(chunk);
+  }
+
+  // Key of the prefix ending in node `node_index` whose last `partial` bits
+  // (1 <= partial <= kStrideBits) are `top_bits`: a heap index in
+  // [2, 2 * kFanout) per node, so every (length, chunk) pair is distinct.
+  [[nodiscard]] static std::size_t StoredKey(int node_index,
+                                             int partial,
+                                             int top_bits) {
+    return static_cast<std::size_t>(node_index) * (2 * kFanout) +
+           ((std::size_t{1} << partial) | static_cast<std::size_t>(top_bits));
+  }
+
+  int NewNode() {
+    const std::size_t node_index = entries_.size() / kFanout;
+    assert(node_index <
+           static_cast<std::size_t>(std::numeric_limits<int>::max()));
+    entries_.resize(entries_.size() + kFanout);
+    return static_cast<int>(node_index);
+  }
+
+  int NewPayload(Payload payload) {
+    payloads_.push_back(std::move(payload));
+    return static_cast<int>(payloads_.size() - 1);
+  }
+
+  void Prefetch(std::size_t entry) const {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(&entries_[entry]);
+#else
+    static_cast<void>(entry);
+#endif
+  }
+
+  // Node i owns entries_[i * kFanout, (i + 1) * kFanout); node 0 is the root.
+  std::vector<Entry> entries_;
+  std::vector<Payload> payloads_;
+  // StoredKey of every stored non-empty prefix -> its index in payloads_.
+  std::unordered_map<std::size_t, int> stored_;
+  int default_payload_ = kNull;
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_PREFIX_MATCH_TRIE_H_
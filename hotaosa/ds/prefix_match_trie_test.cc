@@ -0,0 +1,110 @@
+#include "hotaosa/ds/prefix_match_trie.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+constexpr std::uint32_t Ipv4(std::uint32_t a,
+                             std::uint32_t b,
+                             std::uint32_t c,
+                             std::uint32_t d) {
+  return (a << 24) | (b << 16) | (c << 8) | d;
+}
+
+TEST(PrefixMatchTrieTest, RoutesToMostSpecificPrefix) {
+  PrefixMatchTrie<std::uint32_t, std::string, 32, 8> table;
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 2, 3)), std::nullopt);
+
+  table.Insert(Ipv4(10, 0, 0, 0), 8, "ten");
+  table.Insert(Ipv4(10, 1, 0, 0), 16, "ten-one");
+  table.Insert(Ipv4(10, 1, 2, 0), 23, "ten-one-two");
+  table.Insert(Ipv4(192, 168, 1, 77), 32, "host");
+  EXPECT_EQ(table.Size(), 4);
+
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 9, 9, 9)), "ten");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 9, 9)), "ten-one");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 3, 200)), "ten-one-two");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 4, 0)), "ten-one");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(192, 168, 1, 77)), "host");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(192, 168, 1, 78)), std::nullopt);
+
+  // A shorter prefix inserted later must not shadow a longer one.
+  table.Insert(Ipv4(10, 1, 0, 0), 20, "ten-one-low");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 3, 0)), "ten-one-two");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 15, 0)), "ten-one-low");
+
+  table.Insert(0, 0, "default");
+  table.Insert(Ipv4(10, 1, 2, 0), 23, "replaced");
+  EXPECT_EQ(table.Size(), 6);
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(1, 2, 3, 4)), "default");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 2, 5)), "replaced");
+}
+
+TEST(PrefixMatchTrieTest, ReplacesPrefixShadowedByLongerPrefixes) {
+  PrefixMatchTrie<std::uint32_t, std::string, 32, 8> table;
+  table.Insert(Ipv4(10, 0, 0, 0), 7, "ten-seven");
+  // Both /8s under the /7 overwrite every entry it was expanded onto.
+  table.Insert(Ipv4(10, 0, 0, 0), 8, "ten");
+  table.Insert(Ipv4(11, 0, 0, 0), 8, "eleven");
+  table.Insert(Ipv4(10, 0, 0, 0), 7, "ten-seven-replaced");
+  EXPECT_EQ(table.Size(), 3);
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(10, 1, 1, 1)), "ten");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(11, 1, 1, 1)), "eleven");
+  EXPECT_EQ(table.LongestPrefixMatch(Ipv4(12, 1, 1, 1)), std::nullopt);
+}
+
+template <int kStrideBits>
+void ExpectMatchesBruteForce() {
+  constexpr int kBits = 16;
+  PrefixMatchTrie<std::uint32_t, int, kBits, kStrideBits> table;
+  // (prefix, length, payload), latest payload wins for equal prefixes.
+  std::vector<std::tuple<std::uint32_t, int, int>> routes;
+  std::uint32_t state = 2024;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+  };
+  for (int i = 0; i < 400; ++i) {
+    const int length = static_cast<int>(next() % (kBits + 1));
+    const std::uint32_t prefix = next() & 0xffffu;
+    table.Insert(prefix, length, i);
+    routes.emplace_back(prefix, length, i);
+  }
+  std::vector<std::uint32_t> queries;
+  std::vector<std::optional<int>> expected;
+  for (int i = 0; i < 2000; ++i) {
+    const std::uint32_t value = next() & 0xffffu;
+    int best_length = -1;
+    std::optional<int> best;
+    for (const auto& [prefix, length, payload] : routes) {
+      const int shift = kBits - length;
+      const bool matches =
+          length == 0 || (prefix >> shift) == (value >> shift);
+      if (matches && length >= best_length) {
+        best_length = length;
+        best = payload;
+      }
+    }
+    ASSERT_EQ(table.LongestPrefixMatch(value), best) << value;
+    queries.push_back(value);
+    expected.push_back(best);
+  }
+  EXPECT_EQ(table.LongestPrefixMatchBatch(queries), expected);
+}
+
+TEST(PrefixMatchTrieTest, MatchesBruteForceForEveryStride) {
+  ExpectMatchesBruteForce<1>();
+  ExpectMatchesBruteForce<4>();
+  ExpectMatchesBruteForce<8>();
+  ExpectMatchesBruteForce<16>();
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,186 @@
+#ifndef HOTAOSA_DS_SHARDED_BINARY_TRIE_H_
+#define HOTAOSA_DS_SHARDED_BINARY_TRIE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "hotaosa/ds/binary_trie.h"
+
+namespace hotaosa {
+
+// ShardedBinaryTrie is a thread-safe BinaryTrie multiset for concurrent
+// writers. The top kShardBits bits of a value select one of 2^kShardBits
+// shards; each shard is an independent BinaryTrie over the remaining bits
+// behind its own mutex, so writers to different shards never contend. Each
+// shard also keeps its total in a relaxed atomic on its own cache line; the
+// global CountLess and Kth scan those totals to route to a single shard, so
+// an update touches no state shared with writers to other shards. The scan
+// reads 2^kShardBits totals per query, so kShardBits is capped at 8 (256
+// shards) to keep it cheap next to the in-shard descent.
+//
+// Every operation is atomic with respect to its shard. Queries that combine
+// shards (TotalCount, CountLess, Kth) read the other shards' totals without
+// locking, so under concurrent writes they reflect some interleaving of the
+// in-flight updates; with no writers running they are exact.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          int kShardBits = 6,
+          std::integral CountType = int>
+class ShardedBinaryTrie {
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "ShardedBinaryTrie bit width exceeds ValueType digits");
+  static_assert(0 < kShardBits && kShardBits < kNumBits,
+                "ShardedBinaryTrie needs 0 < kShardBits < kNumBits");
+  static_assert(kShardBits <= 8, "ShardedBinaryTrie shard count too large");
+
+ public:
+  // Per-shard trie over the low kNumBits - kShardBits bits.
+  using ShardTrie = BinaryTrie<ValueType, kNumBits - kShardBits, CountType>;
+
+  ShardedBinaryTrie() : shards_(kNumShards) {}
+
+  ShardedBinaryTrie(const ShardedBinaryTrie&) = delete;
+  ShardedBinaryTrie& operator=(const ShardedBinaryTrie&) = delete;
+  ShardedBinaryTrie(ShardedBinaryTrie&&) = delete;
+  ShardedBinaryTrie& operator=(ShardedBinaryTrie&&) = delete;
+
+  // Inserts `count` copies of `value`. O(kNumBits).
+  void Insert(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    Shard& shard = shards_[ShardOf(value)];
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.trie.Insert(LowPart(value), count);
+    }
+    AddToTotal(shard, count);
+  }
+
+  // Removes up to `count` copies of `value`. O(kNumBits).
+  void Erase(ValueType value, CountType count = 1) {
+    assert(count >= 0);
+    assert((value & ~BitMask()) == 0);
+    Shard& shard = shards_[ShardOf(value)];
+    CountType removed = 0;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      removed = std::min(count, shard.trie.Count(LowPart(value)));
+      shard.trie.Erase(LowPart(value), removed);
+    }
+    AddToTotal(shard, -removed);
+  }
+
+  // Returns the multiplicity of `value`. O(kNumBits).
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const Shard& shard = shards_[ShardOf(value)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.trie.Count(LowPart(value));
+  }
+
+  // Total multiplicity stored. O(2^kShardBits).
+  [[nodiscard]] CountType TotalCount() const {
+    return PrefixTotal(kNumShards);
+  }
+
+  // Returns how many stored values are strictly less than `value`.
+  // O(kNumBits + 2^kShardBits).
+  [[nodiscard]] CountType CountLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const int shard_index = ShardOf(value);
+    const Shard& shard = shards_[shard_index];
+    CountType result = PrefixTotal(shard_index);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return result + shard.trie.CountLess(LowPart(value));
+  }
+
+  // Returns the k-th smallest value (0-indexed), or nullopt when `k` is out
+  // of range, including when a concurrent Erase shrank the chosen shard.
+  // O(kNumBits + 2^kShardBits).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    if (k < 0) {
+      return std::nullopt;
+    }
+    // Scan to the first shard whose prefix total exceeds k.
+    int shard_index = 0;
+    for (; shard_index < kNumShards; ++shard_index) {
+      const CountType total =
+          shards_[shard_index].total.load(std::memory_order_relaxed);
+      if (k < total) {
+        break;
+      }
+      k -= total;
+    }
+    if (shard_index >= kNumShards) {
+      return std::nullopt;
+    }
+    const Shard& shard = shards_[shard_index];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const std::optional<ValueType> low = shard.trie.Kth(k);
+    if (!low.has_value()) {
+      return std::nullopt;
+    }
+    return static_cast<ValueType>(HighPart(shard_index) | *low);
+  }
+
+ private:
+  static constexpr int kNumShards = 1 << kShardBits;
+  static constexpr int kLowBits = kNumBits - kShardBits;
+
+  // Cache-line aligned so neighbouring shard locks do not false-share. The
+  // total sits on a line of its own so lock-free readers scanning totals do
+  // not bounce the line holding the mutex.
+  struct alignas(64) Shard {
+    mutable std::mutex mutex;
+    ShardTrie trie;
+    alignas(64) std::atomic<CountType> total{0};
+  };
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  [[nodiscard]] static int ShardOf(ValueType value) {
+    return static_cast<int>(value >> kLowBits);
+  }
+
+  [[nodiscard]] static ValueType LowPart(ValueType value) {
+    return value & ((ValueType{1} << kLowBits) - ValueType{1});
+  }
+
+  [[nodiscard]] static ValueType HighPart(int shard_index) {
+    return static_cast<ValueType>(shard_index) << kLowBits;
+  }
+
+  static void AddToTotal(Shard& shard, CountType delta) {
+    if (delta != 0) {
+      shard.total.fetch_add(delta, std::memory_order_relaxed);
+    }
+  }
+
+  // Sum of the totals of shards [0, shard_count).
+  [[nodiscard]] CountType PrefixTotal(int shard_count) const {
+    CountType result = 0;
+    for (int i = 0; i < shard_count; ++i) {
+      result += shards_[i].total.load(std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  std::vector<Shard> shards_;
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_SHARDED_BINARY_TRIE_H_
@@ -0,0 +1,57 @@
+// Manually run insert-throughput measurement for ShardedBinaryTrie:
+//
+//   bazel run -c opt //hotaosa:sharded_binary_trie_benchmark
+//
+// Each writer owns one shard, so aggregate throughput should grow with the
+// writer count up to the number of idle cores.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "hotaosa/ds/sharded_binary_trie.h"
+
+namespace {
+
+constexpr std::uint32_t kPerThread = 1 << 20;
+constexpr int kLowBits = 18;
+using Trie = hotaosa::ShardedBinaryTrie<std::uint32_t, 24, 6>;
+
+double InsertsPerSecond(int writer_count) {
+  Trie trie;
+  std::vector<std::thread> writers;
+  const auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < writer_count; ++t) {
+    writers.emplace_back([&trie, t] {
+      // Writer t fills shard t, the values in [t << 18, (t + 1) << 18).
+      const std::uint32_t base = static_cast<std::uint32_t>(t) << kLowBits;
+      for (std::uint32_t i = 0; i < kPerThread; ++i) {
+        trie.Insert(base | ((i * 7919) & ((1u << kLowBits) - 1)));
+      }
+    });
+  }
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return writer_count * static_cast<double>(kPerThread) / elapsed.count();
+}
+
+}  // namespace
+
+int main() {
+  const int max_writers =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  const double single = InsertsPerSecond(1);
+  for (int writers = 1; writers <= max_writers && writers <= 64;
+       writers *= 2) {
+    const double rate = writers == 1 ? single : InsertsPerSecond(writers);
+    std::cout << writers << " writers: " << rate / 1e6 << " M inserts/s ("
+              << rate / single << "x)\n";
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "hotaosa/ds/sharded_binary_trie.h"
+
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(ShardedBinaryTrieTest, GlobalQueriesSpanShards) {
+  ShardedBinaryTrie<std::uint32_t, 12, 3> trie;
+  trie.Insert(5);
+  trie.Insert(600, 2);
+  trie.Insert(4000);
+  trie.Insert(601);
+
+  EXPECT_EQ(trie.TotalCount(), 5);
+  EXPECT_EQ(trie.Count(600), 2);
+  EXPECT_EQ(trie.CountLess(600), 1);
+  EXPECT_EQ(trie.CountLess(4000), 4);
+  EXPECT_EQ(trie.Kth(0), std::optional<std::uint32_t>(5));
+  EXPECT_EQ(trie.Kth(2), std::optional<std::uint32_t>(600));
+  EXPECT_EQ(trie.Kth(3), std::optional<std::uint32_t>(601));
+  EXPECT_EQ(trie.Kth(4), std::optional<std::uint32_t>(4000));
+  EXPECT_FALSE(trie.Kth(5).has_value());
+
+  trie.Erase(600, 5);
+  EXPECT_EQ(trie.TotalCount(), 3);
+  EXPECT_EQ(trie.Kth(1), std::optional<std::uint32_t>(601));
+}
+
+TEST(ShardedBinaryTrieTest, ConcurrentWritersAgreeWithSerialCounts) {
+  constexpr int kThreads = 4;
+  constexpr std::uint32_t kPerThread = 2000;
+  ShardedBinaryTrie<std::uint32_t, 16, 4> trie;
+  std::vector<std::thread> writers;
+  for (int t = 0; t < kThreads; ++t) {
+    writers.emplace_back([&trie, t] {
+      for (std::uint32_t i = 0; i < kPerThread; ++i) {
+        const std::uint32_t value = (i * 7919 + t * 13) % 65536;
+        trie.Insert(value, 2);
+        trie.Erase(value);
+      }
+    });
+  }
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+
+  EXPECT_EQ(trie.TotalCount(), kThreads * static_cast<int>(kPerThread));
+  std::uint32_t previous = 0;
+  for (int k = 0; k < trie.TotalCount(); k += 97) {
+    const std::optional<std::uint32_t> value = trie.Kth(k);
+    ASSERT_TRUE(value.has_value());
+    EXPECT_GE(*value, previous);
+    EXPECT_LE(trie.CountLess(*value), k);
+    EXPECT_GT(trie.CountLess(*value) + trie.Count(*value), k);
+    previous = *value;
+  }
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,276 @@
+#ifndef HOTAOSA_DS_STATIC_BINARY_TRIE_H_
+#define HOTAOSA_DS_STATIC_BINARY_TRIE_H_
+
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <vector>
+
+#include "hotaosa/ds/binary_trie.h"
+#include "hotaosa/ds/bit_vector.h"
+
+namespace hotaosa {
+
+// StaticBinaryTrie is a read-only BinaryTrie in a level-ordered succinct
+// layout. The nodes of each depth are numbered in key order, and every node
+// owns two bits in its level's BitVector marking which children exist. The
+// child in slot p is the Rank1(p)-th node of the next level, so no child
+// indices are stored. Each node costs about 2.25 bits of topology (two child
+// bits plus rank samples) and sizeof(CountType) bytes for its subtree count,
+// kept in per-level arrays; the count dominates, so a node takes roughly
+// 4.3 bytes with int counts. Queries match BinaryTrie's, including the lazy
+// XorAll mask.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits,
+          std::integral CountType = int>
+class StaticBinaryTrie {
+  static_assert(kNumBits > 0, "StaticBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "StaticBinaryTrie bit width exceeds ValueType digits");
+
+ public:
+  // Snapshots the values of `trie` as seen through its XOR mask.
+  // O(number of nodes).
+  template <bool kTrackSums>
+  explicit StaticBinaryTrie(
+      const BinaryTrie<ValueType, kNumBits, CountType, kTrackSums>& trie)
+      : StaticBinaryTrie() {
+    for (const auto& [value, count] : trie) {
+      Append(value, count);
+    }
+    Build();
+  }
+
+  // Builds from values sorted in non-decreasing order, duplicates allowed.
+  // O(N * kNumBits).
+  template <std::ranges::input_range Range>
+    requires std::convertible_to<std::ranges::range_value_t<Range>, ValueType>
+  explicit StaticBinaryTrie(const Range& sorted_values) : StaticBinaryTrie() {
+    std::optional<ValueType> run_value;
+    CountType run_count = 0;
+    for (const auto& element : sorted_values) {
+      const ValueType value = static_cast<ValueType>(element);
+      if (run_value == value) {
+        ++run_count;
+        continue;
+      }
+      if (run_value.has_value()) {
+        Append(*run_value, run_count);
+      }
+      run_value = value;
+      run_count = 1;
+    }
+    if (run_value.has_value()) {
+      Append(*run_value, run_count);
+    }
+    Build();
+  }
+
+  StaticBinaryTrie(const StaticBinaryTrie&) = default;
+  StaticBinaryTrie& operator=(const StaticBinaryTrie&) = default;
+  StaticBinaryTrie(StaticBinaryTrie&&) = default;
+  StaticBinaryTrie& operator=(StaticBinaryTrie&&) = default;
+
+  // Returns the multiplicity of `value`. O(kNumBits).
+  [[nodiscard]] CountType Count(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    const ValueType stored = value ^ xor_mask_;
+    int node_index = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      node_index = Child(depth, node_index, StoredBit(stored, depth));
+      if (node_index == kNull) {
+        return static_cast<CountType>(0);
+      }
+    }
+    return counts_[kNumBits][node_index];
+  }
+
+  // Total multiplicity stored. O(1).
+  [[nodiscard]] CountType TotalCount() const { return counts_[0][0]; }
+
+  // Returns how many stored values are strictly less than `value`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountLess(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    CountType result = 0;
+    int node_index = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const int mask_bit = StoredBit(xor_mask_, depth);
+      const int actual_bit = StoredBit(value, depth);
+      if (actual_bit == 1) {
+        result += SubtreeCount(depth + 1, Child(depth, node_index, mask_bit));
+      }
+      node_index = Child(depth, node_index, actual_bit ^ mask_bit);
+      if (node_index == kNull) {
+        return result;
+      }
+    }
+    return result;
+  }
+
+  // Returns the k-th smallest value (0-indexed). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(CountType k) const {
+    if (k < 0 || k >= TotalCount()) {
+      return std::nullopt;
+    }
+    ValueType result = 0;
+    int node_index = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      const int mask_bit = StoredBit(xor_mask_, depth);
+      const int zero_child = Child(depth, node_index, mask_bit);
+      const CountType zero_count = SubtreeCount(depth + 1, zero_child);
+      if (k < zero_count) {
+        node_index = zero_child;
+      } else {
+        k -= zero_count;
+        result |= ValueType{1} << (kNumBits - 1 - depth);
+        node_index = Child(depth, node_index, mask_bit ^ 1);
+      }
+    }
+    return result;
+  }
+
+  // Returns the maximum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(ValueType value) const {
+    return FindExtremeXor(value, true);
+  }
+
+  // Returns the minimum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(ValueType value) const {
+    return FindExtremeXor(value, false);
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(1).
+  void XorAll(ValueType mask) { xor_mask_ ^= (mask & BitMask()); }
+
+  // Heap bytes used by the level bit vectors and count arrays.
+  // O(kNumBits).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    std::size_t bytes = 0;
+    for (const BitVector& level : levels_) {
+      bytes += level.MemoryUsage();
+    }
+    for (const std::vector<CountType>& counts : counts_) {
+      bytes += counts.capacity() * sizeof(CountType);
+    }
+    return bytes;
+  }
+
+ private:
+  static constexpr int kNull = -1;
+
+  // An empty trie: a lone root without children.
+  StaticBinaryTrie() : levels_(kNumBits), counts_(kNumBits + 1) {
+    counts_[0].push_back(0);
+    levels_[0].PushBack(false);
+    levels_[0].PushBack(false);
+  }
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Bit of `value` that nodes at `depth` branch on.
+  [[nodiscard]] static int StoredBit(ValueType value, int depth) {
+    return static_cast<int>((value >> (kNumBits - 1 - depth)) & 1);
+  }
+
+  // Index within depth + 1 of the `direction` child of node `node_index` at
+  // `depth`, or kNull.
+  [[nodiscard]] int Child(int depth, int node_index, int direction) const {
+    const std::size_t slot = 2 * static_cast<std::size_t>(node_index) +
+                             static_cast<std::size_t>(direction);
+    if (!levels_[depth].Get(slot)) {
+      return kNull;
+    }
+    return static_cast<int>(levels_[depth].Rank1(slot));
+  }
+
+  [[nodiscard]] CountType SubtreeCount(int depth, int node_index) const {
+    return node_index == kNull ? static_cast<CountType>(0)
+                               : counts_[depth][node_index];
+  }
+
+  // Adds `count` copies of `value`, which must exceed every value appended
+  // so far. The nodes on the previous value's path are the last nodes of
+  // their levels, so only the levels below the shared prefix grow.
+  void Append(ValueType value, CountType count) {
+    assert((value & ~BitMask()) == 0);
+    assert(count > 0);
+    int shared_depth = 0;
+    if (last_value_.has_value()) {
+      assert(*last_value_ < value);
+      const ValueType diff = *last_value_ ^ value;
+      shared_depth = kNumBits - static_cast<int>(std::bit_width(diff));
+    }
+    last_value_ = value;
+    for (int depth = shared_depth; depth < kNumBits; ++depth) {
+      const std::size_t parent = counts_[depth].size() - 1;
+      levels_[depth].Set(2 * parent +
+                         static_cast<std::size_t>(StoredBit(value, depth)));
+      counts_[depth + 1].push_back(0);
+      if (depth + 1 < kNumBits) {
+        levels_[depth + 1].PushBack(false);
+        levels_[depth + 1].PushBack(false);
+      }
+    }
+    for (std::vector<CountType>& counts : counts_) {
+      counts.back() += count;
+    }
+  }
+
+  void Build() {
+    for (BitVector& level : levels_) {
+      level.Build();
+    }
+    for (std::vector<CountType>& counts : counts_) {
+      counts.shrink_to_fit();
+    }
+  }
+
+  // Returns (best element XOR `value`) for the largest or smallest XOR.
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(ValueType value,
+                                                        bool maximize) const {
+    assert((value & ~BitMask()) == 0);
+    if (TotalCount() <= 0) {
+      return std::nullopt;
+    }
+    const ValueType stored = value ^ xor_mask_;
+    ValueType result = 0;
+    int node_index = 0;
+    for (int depth = 0; depth < kNumBits; ++depth) {
+      // The stored direction opposite to `stored` sets the XOR bit.
+      const int one_direction = StoredBit(stored, depth) ^ 1;
+      int direction = one_direction ^ static_cast<int>(!maximize);
+      int child = Child(depth, node_index, direction);
+      if (child == kNull) {
+        direction ^= 1;
+        child = Child(depth, node_index, direction);
+      }
+      if (direction == one_direction) {
+        result |= ValueType{1} << (kNumBits - 1 - depth);
+      }
+      node_index = child;
+    }
+    return result;
+  }
+
+  // levels_[d]: two child bits per node at depth d.
+  std::vector<BitVector> levels_;
+  // counts_[d][i]: subtree count of the i-th node at depth d.
+  std::vector<std::vector<CountType>> counts_;
+  std::optional<ValueType> last_value_;
+  ValueType xor_mask_{0};
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_STATIC_BINARY_TRIE_H_
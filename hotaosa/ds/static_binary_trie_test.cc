@@ -0,0 +1,56 @@
+#include "hotaosa/ds/static_binary_trie.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hotaosa/ds/binary_trie.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(StaticBinaryTrieTest, MatchesSourceBinaryTrie) {
+  BinaryTrie<std::uint32_t, 10> trie;
+  for (std::uint32_t i = 0; i < 60; ++i) {
+    trie.Insert((i * 397) % 1024, static_cast<int>(i % 3) + 1);
+  }
+  trie.XorAll(0x2A5);
+  const StaticBinaryTrie<std::uint32_t, 10> frozen(trie);
+
+  EXPECT_EQ(frozen.TotalCount(), trie.TotalCount());
+  for (std::uint32_t value = 0; value < 1024; value += 7) {
+    EXPECT_EQ(frozen.Count(value), trie.Count(value));
+    EXPECT_EQ(frozen.CountLess(value), trie.CountLess(value));
+    EXPECT_EQ(frozen.MaxXor(value), trie.MaxXor(value));
+    EXPECT_EQ(frozen.MinXor(value), trie.MinXor(value));
+  }
+  for (int k = 0; k <= trie.TotalCount(); ++k) {
+    EXPECT_EQ(frozen.Kth(k), trie.Kth(k));
+  }
+}
+
+TEST(StaticBinaryTrieTest, BuildsFromSortedValues) {
+  const std::vector<std::uint8_t> values = {1, 3, 3, 7, 200};
+  StaticBinaryTrie<std::uint8_t> trie(values);
+  EXPECT_EQ(trie.TotalCount(), 5);
+  EXPECT_EQ(trie.Count(3), 2);
+  EXPECT_EQ(trie.Count(4), 0);
+  EXPECT_EQ(trie.CountLess(7), 3);
+  EXPECT_EQ(trie.Kth(4), std::optional<std::uint8_t>(200));
+  EXPECT_EQ(trie.MaxXor(0), std::optional<std::uint8_t>(200));
+
+  trie.XorAll(1);  // {0, 2, 2, 6, 201}
+  EXPECT_EQ(trie.Kth(0), std::optional<std::uint8_t>(0));
+  EXPECT_EQ(trie.CountLess(6), 3);
+  EXPECT_EQ(trie.MinXor(7), std::optional<std::uint8_t>(1));
+
+  const StaticBinaryTrie<std::uint8_t> empty(std::vector<std::uint8_t>{});
+  EXPECT_EQ(empty.TotalCount(), 0);
+  EXPECT_EQ(empty.CountLess(100), 0);
+  EXPECT_FALSE(empty.Kth(0).has_value());
+  EXPECT_FALSE(empty.MaxXor(1).has_value());
+}
+
+}  // namespace
+}  // namespace hotaosa
@@ -0,0 +1,220 @@
+#ifndef HOTAOSA_DS_WAVELET_MATRIX_H_
+#define HOTAOSA_DS_WAVELET_MATRIX_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "hotaosa/ds/bit_vector.h"
+
+namespace hotaosa {
+
+// WaveletMatrix is the static, array-indexed counterpart of BinaryTrie: it
+// answers Kth, CountLess, Count and MaxXor/MinXor restricted to a subarray
+// a[l, r). Level d holds bit (kNumBits - 1 - d) of every element, after the
+// elements were stably partitioned by the higher bits (zeros first), so a
+// query range maps to the next level with two ranks. Memory is N * kNumBits
+// bits plus the BitVector rank directories; each query is O(kNumBits).
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits>
+class WaveletMatrix {
+  static_assert(kNumBits > 0, "WaveletMatrix requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "WaveletMatrix bit width exceeds ValueType digits");
+
+ public:
+  // Builds over `values`, which become a[0, N). O(N * kNumBits).
+  explicit WaveletMatrix(std::vector<ValueType> values)
+      : size_(static_cast<int>(values.size())) {
+    std::vector<ValueType> ones;
+    ones.reserve(values.size());
+    for (int level = 0; level < kNumBits; ++level) {
+      const int bit = kNumBits - 1 - level;
+      BitVector& bits = levels_[level];
+      bits = BitVector(values.size());
+      std::size_t zero_count = 0;
+      ones.clear();
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        assert((values[i] & ~BitMask()) == 0);
+        if (((values[i] >> bit) & 1) != 0) {
+          bits.Set(i);
+          ones.push_back(values[i]);
+        } else {
+          values[zero_count++] = values[i];
+        }
+      }
+      bits.Build();
+      zeros_[level] = static_cast<int>(zero_count);
+      std::copy(ones.begin(), ones.end(), values.begin() + zero_count);
+    }
+  }
+
+  // Number of elements. O(1).
+  [[nodiscard]] int Size() const { return size_; }
+
+  // Returns a[index]. O(kNumBits).
+  [[nodiscard]] ValueType Get(int index) const {
+    assert(0 <= index && index < size_);
+    ValueType result = 0;
+    for (int level = 0; level < kNumBits; ++level) {
+      const bool one = levels_[level].Get(index);
+      if (one) {
+        result |= ValueType{1} << (kNumBits - 1 - level);
+      }
+      index = Descend(level, index, one);
+    }
+    return result;
+  }
+
+  // Returns the k-th smallest (0-indexed) element of a[l, r).
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(int l, int r, int k) const {
+    assert(0 <= l && l <= r && r <= size_);
+    if (k < 0 || k >= r - l) {
+      return std::nullopt;
+    }
+    ValueType result = 0;
+    for (int level = 0; level < kNumBits; ++level) {
+      const int zero_count = ZerosIn(level, l, r);
+      const bool one = k >= zero_count;
+      if (one) {
+        k -= zero_count;
+        result |= ValueType{1} << (kNumBits - 1 - level);
+      }
+      l = Descend(level, l, one);
+      r = Descend(level, r, one);
+    }
+    return result;
+  }
+
+  // Number of elements of a[l, r) strictly less than `value`. O(kNumBits).
+  [[nodiscard]] int CountLess(int l, int r, ValueType value) const {
+    assert(0 <= l && l <= r && r <= size_);
+    assert((value & ~BitMask()) == 0);
+    int result = 0;
+    for (int level = 0; level < kNumBits && l < r; ++level) {
+      const bool one = ((value >> (kNumBits - 1 - level)) & 1) != 0;
+      if (one) {
+        result += ZerosIn(level, l, r);
+      }
+      l = Descend(level, l, one);
+      r = Descend(level, r, one);
+    }
+    return result;
+  }
+
+  // Number of occurrences of `value` in a[l, r). O(kNumBits).
+  [[nodiscard]] int Count(int l, int r, ValueType value) const {
+    assert(0 <= l && l <= r && r <= size_);
+    assert((value & ~BitMask()) == 0);
+    for (int level = 0; level < kNumBits && l < r; ++level) {
+      const bool one = ((value >> (kNumBits - 1 - level)) & 1) != 0;
+      l = Descend(level, l, one);
+      r = Descend(level, r, one);
+    }
+    return r - l;
+  }
+
+  // Number of elements of a[l, r) in the closed range [lo, hi].
+  // O(kNumBits).
+  [[nodiscard]] int CountInRange(int l,
+                                 int r,
+                                 ValueType lo,
+                                 ValueType hi) const {
+    if (hi < lo) {
+      return 0;
+    }
+    return CountLess(l, r, hi) + Count(l, r, hi) - CountLess(l, r, lo);
+  }
+
+  // Returns the maximum of (a[i] XOR `value`) over i in [l, r).
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MaxXor(int l,
+                                                int r,
+                                                ValueType value) const {
+    return FindExtremeXor(l, r, value, true);
+  }
+
+  // Returns the minimum of (a[i] XOR `value`) over i in [l, r).
+  // O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> MinXor(int l,
+                                                int r,
+                                                ValueType value) const {
+    return FindExtremeXor(l, r, value, false);
+  }
+
+  // Heap bytes used by the level bit vectors. O(kNumBits).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    std::size_t bytes = 0;
+    for (const BitVector& level : levels_) {
+      bytes += level.MemoryUsage();
+    }
+    return bytes;
+  }
+
+ private:
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Zero bits of `level` within [l, r).
+  [[nodiscard]] int ZerosIn(int level, int l, int r) const {
+    return static_cast<int>(levels_[level].Rank0(r) - levels_[level].Rank0(l));
+  }
+
+  // Position on level + 1 of the boundary `index` of level `level`, within
+  // the zero or the one partition.
+  [[nodiscard]] int Descend(int level, int index, bool one) const {
+    if (one) {
+      return zeros_[level] + static_cast<int>(levels_[level].Rank1(index));
+    }
+    return static_cast<int>(levels_[level].Rank0(index));
+  }
+
+  [[nodiscard]] std::optional<ValueType> FindExtremeXor(int l,
+                                                        int r,
+                                                        ValueType value,
+                                                        bool maximize) const {
+    assert(0 <= l && l <= r && r <= size_);
+    assert((value & ~BitMask()) == 0);
+    if (l == r) {
+      return std::nullopt;
+    }
+    ValueType result = 0;
+    for (int level = 0; level < kNumBits; ++level) {
+      const int bit = kNumBits - 1 - level;
+      const bool value_one = ((value >> bit) & 1) != 0;
+      // Prefer the partition that sets (maximize) or clears the XOR bit.
+      bool one = maximize != value_one;
+      const int preferred_count =
+          one ? (r - l) - ZerosIn(level, l, r) : ZerosIn(level, l, r);
+      if (preferred_count == 0) {
+        one = !one;
+      }
+      if (one != value_one) {
+        result |= ValueType{1} << bit;
+      }
+      l = Descend(level, l, one);
+      r = Descend(level, r, one);
+    }
+    return result;
+  }
+
+  std::array<BitVector, kNumBits> levels_;
+  // zeros_[d]: zero bits on level d, i.e. where its one partition starts.
+  std::array<int, kNumBits> zeros_{};
+  int size_ = 0;
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_WAVELET_MATRIX_H_
@@ -0,0 +1,83 @@
+#include "hotaosa/ds/wavelet_matrix.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+TEST(WaveletMatrixTest, EmptyRangesReturnNothing) {
+  const WaveletMatrix<std::uint32_t, 8> matrix({3, 1, 4});
+  EXPECT_EQ(matrix.Size(), 3);
+  EXPECT_EQ(matrix.Kth(1, 1, 0), std::nullopt);
+  EXPECT_EQ(matrix.Kth(0, 3, 3), std::nullopt);
+  EXPECT_EQ(matrix.MaxXor(2, 2, 7), std::nullopt);
+  EXPECT_EQ(matrix.CountLess(2, 2, 255), 0);
+  EXPECT_EQ(matrix.Count(0, 0, 3), 0);
+  EXPECT_EQ(matrix.CountInRange(0, 3, 4, 1), 0);
+}
+
+TEST(WaveletMatrixTest, RangeQueriesMatchBruteForce) {
+  constexpr int kBits = 6;
+  std::vector<std::uint32_t> values;
+  std::uint32_t state = 12345;
+  for (int i = 0; i < 300; ++i) {
+    state = state * 1103515245u + 12345u;
+    values.push_back((state >> 16) & 63u);
+  }
+  const WaveletMatrix<std::uint32_t, kBits> matrix(values);
+
+  for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+    ASSERT_EQ(matrix.Get(i), values[i]);
+  }
+  for (int l = 0; l <= 300; l += 37) {
+    for (int r = l; r <= 300; r += 29) {
+      std::vector<std::uint32_t> sorted(values.begin() + l,
+                                        values.begin() + r);
+      std::sort(sorted.begin(), sorted.end());
+      for (int k = 0; k < r - l; ++k) {
+        ASSERT_EQ(matrix.Kth(l, r, k), sorted[k]);
+      }
+      for (std::uint32_t value = 0; value < 64; ++value) {
+        const auto less = std::lower_bound(sorted.begin(), sorted.end(),
+                                           value) - sorted.begin();
+        const auto equal = std::count(sorted.begin(), sorted.end(), value);
+        EXPECT_EQ(matrix.CountLess(l, r, value), less);
+        EXPECT_EQ(matrix.Count(l, r, value), equal);
+        const std::uint32_t hi = std::min(value + 9, 63u);
+        EXPECT_EQ(matrix.CountInRange(l, r, value, hi),
+                  std::upper_bound(sorted.begin(), sorted.end(), hi) -
+                      sorted.begin() - less);
+        if (l == r) {
+          continue;
+        }
+        std::uint32_t best_max = 0;
+        std::uint32_t best_min = 63;
+        for (const std::uint32_t element : sorted) {
+          best_max = std::max(best_max, element ^ value);
+          best_min = std::min(best_min, element ^ value);
+        }
+        EXPECT_EQ(matrix.MaxXor(l, r, value), best_max);
+        EXPECT_EQ(matrix.MinXor(l, r, value), best_min);
+      }
+    }
+  }
+}
+
+TEST(WaveletMatrixTest, FullWidthValues) {
+  const std::vector<std::uint64_t> values = {~std::uint64_t{0}, 0,
+                                             std::uint64_t{1} << 63, 42};
+  const WaveletMatrix<std::uint64_t> matrix(values);
+  EXPECT_EQ(matrix.Kth(0, 4, 3), ~std::uint64_t{0});
+  EXPECT_EQ(matrix.Kth(1, 4, 1), 42u);
+  EXPECT_EQ(matrix.CountLess(0, 4, std::uint64_t{1} << 63), 2);
+  EXPECT_EQ(matrix.MaxXor(1, 3, 0), std::uint64_t{1} << 63);
+  EXPECT_EQ(matrix.MinXor(0, 4, 43), 1u);
+}
+
+}  // namespace
+}  // namespace hotaosa
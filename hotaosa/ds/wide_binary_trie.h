@@ -0,0 +1,344 @@
+#ifndef HOTAOSA_DS_WIDE_BINARY_TRIE_H_
+#define HOTAOSA_DS_WIDE_BINARY_TRIE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace hotaosa {
+
+// WideKeyTraits exposes a key as little-endian 64-bit words: bit b of the key
+// is bit (b % 64) of Word(key, b / 64), and keys order by their most
+// significant differing bit.
+template <typename Key>
+struct WideKeyTraits;
+
+#ifdef __SIZEOF_INT128__
+// Unsigned 128-bit key; __extension__ keeps -Wpedantic quiet.
+__extension__ typedef unsigned __int128 UInt128;
+
+template <>
+struct WideKeyTraits<UInt128> {
+  static constexpr int kWords = 2;
+
+  [[nodiscard]] static constexpr std::uint64_t Word(UInt128 key, int index) {
+    return static_cast<std::uint64_t>(key >> (64 * index));
+  }
+
+  static constexpr void SetWord(UInt128& key, int index, std::uint64_t word) {
+    const int shift = 64 * index;
+    key &= ~(static_cast<UInt128>(~std::uint64_t{0}) << shift);
+    key |= static_cast<UInt128>(word) << shift;
+  }
+};
+#endif  // __SIZEOF_INT128__
+
+// Fixed-width multi-word keys; element 0 holds the least significant word.
+template <std::size_t kWidth>
+struct WideKeyTraits<std::array<std::uint64_t, kWidth>> {
+  static_assert(kWidth > 0, "WideKeyTraits requires at least one word");
+  static constexpr int kWords = static_cast<int>(kWidth);
+
+  [[nodiscard]] static constexpr std::uint64_t Word(
+      const std::array<std::uint64_t, kWidth>& key,
+      int index) {
+    return key[index];
+  }
+
+  static constexpr void SetWord(std::array<std::uint64_t, kWidth>& key,
+                                int index,
+                                std::uint64_t word) {
+    key[index] = word;
+  }
+};
+
+template <typename Key>
+concept WideKey = std::regular<Key> && requires(Key key, std::uint64_t word) {
+  { WideKeyTraits<Key>::kWords } -> std::convertible_to<int>;
+  { WideKeyTraits<Key>::Word(key, 0) } -> std::same_as<std::uint64_t>;
+  WideKeyTraits<Key>::SetWord(key, 0, word);
+};
+
+// WideBinaryTrie is a BinaryTrie over keys wider than any built-in unsigned
+// integer, such as 128-bit hashes or 256-bit bitmask states. Keys are read
+// through WideKeyTraits one 64-bit word at a time: each descent loads a word
+// of the key and of the lazy XOR mask once, XORs them, and then extracts the
+// word's bits with shifts. Bits at positions >= kNumBits must be zero.
+// Nodes emptied by Erase are recycled as in BinaryTrie.
+template <WideKey Key,
+          int kNumBits = 64 * WideKeyTraits<Key>::kWords,
+          std::integral CountType = int>
+class WideBinaryTrie {
+  using Traits = WideKeyTraits<Key>;
+
+  static_assert(kNumBits > 0, "WideBinaryTrie requires at least one bit");
+  static_assert(kNumBits <= 64 * Traits::kWords,
+                "WideBinaryTrie bit width exceeds the key width");
+
+ public:
+  WideBinaryTrie() : nodes_(1) {}
+
+  WideBinaryTrie(const WideBinaryTrie&) = delete;
+  WideBinaryTrie& operator=(const WideBinaryTrie&) = delete;
+  WideBinaryTrie(WideBinaryTrie&&) = delete;
+  WideBinaryTrie& operator=(WideBinaryTrie&&) = delete;
+
+  // Inserts `count` copies of `value`. O(kNumBits).
+  void Insert(const Key& value, CountType count = 1) {
+    assert(count >= 0);
+    assert(IsInRange(value));
+    if (count == 0) {
+      return;
+    }
+    int node_index = 0;
+    nodes_[node_index].count += count;
+    for (int word = kTopWord; word >= 0; --word) {
+      const std::uint64_t stored = StoredWord(value, word);
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int direction = static_cast<int>((stored >> offset) & 1);
+        int child_index = nodes_[node_index].children[direction];
+        if (child_index == kNull) {
+          child_index = NewNode();
+          nodes_[node_index].children[direction] = child_index;
+        }
+        node_index = child_index;
+        nodes_[node_index].count += count;
+      }
+    }
+  }
+
+  // Removes up to `count` copies of `value`. O(kNumBits).
+  void Erase(const Key& value, CountType count = 1) {
+    assert(count >= 0);
+    assert(IsInRange(value));
+    if (count == 0) {
+      return;
+    }
+    std::array<int, kNumBits + 1> path{};
+    int depth = 0;
+    for (int word = kTopWord; word >= 0; --word) {
+      const std::uint64_t stored = StoredWord(value, word);
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int direction = static_cast<int>((stored >> offset) & 1);
+        const int child_index = nodes_[path[depth]].children[direction];
+        if (child_index == kNull) {
+          return;
+        }
+        path[++depth] = child_index;
+      }
+    }
+    const CountType removable = std::min(count, nodes_[path[kNumBits]].count);
+    if (removable == 0) {
+      return;
+    }
+    int top_emptied = kNull;
+    for (int level = kNumBits; level >= 0; --level) {
+      nodes_[path[level]].count -= removable;
+      if (level > 0 && nodes_[path[level]].count == 0) {
+        top_emptied = level;
+      }
+    }
+    if (top_emptied == kNull) {
+      return;
+    }
+    Node& parent = nodes_[path[top_emptied - 1]];
+    parent.children[parent.children[1] == path[top_emptied] ? 1 : 0] = kNull;
+    for (int level = top_emptied; level <= kNumBits; ++level) {
+      free_list_.push_back(path[level]);
+    }
+  }
+
+  // Returns the multiplicity of `value`. O(kNumBits).
+  [[nodiscard]] CountType Count(const Key& value) const {
+    assert(IsInRange(value));
+    int node_index = 0;
+    for (int word = kTopWord; word >= 0; --word) {
+      const std::uint64_t stored = StoredWord(value, word);
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int direction = static_cast<int>((stored >> offset) & 1);
+        node_index = nodes_[node_index].children[direction];
+        if (node_index == kNull) {
+          return static_cast<CountType>(0);
+        }
+      }
+    }
+    return nodes_[node_index].count;
+  }
+
+  // Returns whether `value` is stored. O(kNumBits).
+  [[nodiscard]] bool Contains(const Key& value) const {
+    return Count(value) > 0;
+  }
+
+  // Total multiplicity stored in the trie. O(1).
+  [[nodiscard]] CountType TotalCount() const { return nodes_[0].count; }
+
+  // Returns how many stored values are strictly less than `value`.
+  // O(kNumBits).
+  [[nodiscard]] CountType CountLess(const Key& value) const {
+    assert(IsInRange(value));
+    CountType result = 0;
+    int node_index = 0;
+    for (int word = kTopWord; word >= 0; --word) {
+      const std::uint64_t actual = Traits::Word(value, word);
+      const std::uint64_t mask = Traits::Word(xor_mask_, word);
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int actual_bit = static_cast<int>((actual >> offset) & 1);
+        const int mask_bit = static_cast<int>((mask >> offset) & 1);
+        if (actual_bit == 1) {
+          result += SubtreeCount(nodes_[node_index].children[mask_bit]);
+        }
+        node_index = nodes_[node_index].children[actual_bit ^ mask_bit];
+        if (node_index == kNull) {
+          return result;
+        }
+      }
+    }
+    return result;
+  }
+
+  // Returns the k-th smallest value (0-indexed). O(kNumBits).
+  [[nodiscard]] std::optional<Key> Kth(CountType k) const {
+    if (k < 0 || k >= TotalCount()) {
+      return std::nullopt;
+    }
+    Key result{};
+    int node_index = 0;
+    for (int word = kTopWord; word >= 0; --word) {
+      const std::uint64_t mask = Traits::Word(xor_mask_, word);
+      std::uint64_t result_word = 0;
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int mask_bit = static_cast<int>((mask >> offset) & 1);
+        const int zero_child = nodes_[node_index].children[mask_bit];
+        const CountType zero_count = SubtreeCount(zero_child);
+        if (k < zero_count) {
+          node_index = zero_child;
+        } else {
+          k -= zero_count;
+          result_word |= std::uint64_t{1} << offset;
+          node_index = nodes_[node_index].children[mask_bit ^ 1];
+        }
+      }
+      Traits::SetWord(result, word, result_word);
+    }
+    return result;
+  }
+
+  // Returns the maximum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<Key> MaxXor(const Key& value) const {
+    return FindExtremeXor(value, true);
+  }
+
+  // Returns the minimum of (element XOR `value`). O(kNumBits).
+  [[nodiscard]] std::optional<Key> MinXor(const Key& value) const {
+    return FindExtremeXor(value, false);
+  }
+
+  // Applies XOR with `mask` lazily to every stored value. O(kNumBits / 64).
+  void XorAll(const Key& mask) {
+    assert(IsInRange(mask));
+    for (int word = 0; word < Traits::kWords; ++word) {
+      Traits::SetWord(xor_mask_,
+                      word,
+                      Traits::Word(xor_mask_, word) ^ Traits::Word(mask, word));
+    }
+  }
+
+  // Heap bytes currently reserved by the node pool and free list. O(1).
+  [[nodiscard]] std::size_t MemoryUsage() const {
+    return nodes_.capacity() * sizeof(Node) +
+           free_list_.capacity() * sizeof(int);
+  }
+
+ private:
+  static constexpr int kNull = -1;
+  static constexpr int kTopWord = (kNumBits - 1) / 64;
+
+  struct Node {
+    std::array<int, 2> children{{kNull, kNull}};
+    CountType count{0};
+  };
+
+  // Highest bit offset used within `word`.
+  [[nodiscard]] static constexpr int TopOffset(int word) {
+    return word == kTopWord ? (kNumBits - 1) % 64 : 63;
+  }
+
+  [[nodiscard]] static bool IsInRange(const Key& value) {
+    for (int word = kTopWord; word < Traits::kWords; ++word) {
+      const int used = word == kTopWord ? TopOffset(word) + 1 : 0;
+      const std::uint64_t word_value = Traits::Word(value, word);
+      if (used < 64 && (word_value >> used) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Word `word` of `value` as stored, i.e. with the mask applied.
+  [[nodiscard]] std::uint64_t StoredWord(const Key& value, int word) const {
+    return Traits::Word(value, word) ^ Traits::Word(xor_mask_, word);
+  }
+
+  [[nodiscard]] CountType SubtreeCount(int node_index) const {
+    return node_index == kNull ? static_cast<CountType>(0)
+                               : nodes_[node_index].count;
+  }
+
+  // Returns (best element XOR `value`) for the largest or smallest XOR.
+  [[nodiscard]] std::optional<Key> FindExtremeXor(const Key& value,
+                                                  bool maximize) const {
+    assert(IsInRange(value));
+    if (TotalCount() <= 0) {
+      return std::nullopt;
+    }
+    Key result{};
+    int node_index = 0;
+    for (int word = kTopWord; word >= 0; --word) {
+      // Stored direction that makes the XOR bit 1 is the complement of it.
+      const std::uint64_t stored = StoredWord(value, word);
+      std::uint64_t result_word = 0;
+      for (int offset = TopOffset(word); offset >= 0; --offset) {
+        const int one_direction =
+            static_cast<int>((stored >> offset) & 1) ^ 1;
+        const int preferred = one_direction ^ static_cast<int>(!maximize);
+        int next = nodes_[node_index].children[preferred];
+        int direction = preferred;
+        if (SubtreeCount(next) <= 0) {
+          direction ^= 1;
+          next = nodes_[node_index].children[direction];
+        }
+        if (direction == one_direction) {
+          result_word |= std::uint64_t{1} << offset;
+        }
+        node_index = next;
+      }
+      Traits::SetWord(result, word, result_word);
+    }
+    return result;
+  }
+
+  int NewNode() {
+    if (!free_list_.empty()) {
+      const int idx = free_list_.back();
+      free_list_.pop_back();
+      nodes_[idx] = Node{};
+      return idx;
+    }
+    nodes_.emplace_back();
+    return static_cast<int>(nodes_.size() - 1);
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<int> free_list_;
+  Key xor_mask_{};
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_WIDE_BINARY_TRIE_H_
@@ -0,0 +1,74 @@
+#include "hotaosa/ds/wide_binary_trie.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+using Key256 = std::array<std::uint64_t, 4>;
+
+#ifdef __SIZEOF_INT128__
+TEST(WideBinaryTrieTest, Int128KeysSupportOrderAndXorQueries) {
+  using Key = UInt128;
+  const Key high = static_cast<Key>(1) << 100;
+  WideBinaryTrie<Key> trie;
+  trie.Insert(5);
+  trie.Insert(high | 3, 2);
+  trie.Insert(high << 20);
+
+  EXPECT_EQ(trie.TotalCount(), 4);
+  EXPECT_EQ(trie.Count(high | 3), 2);
+  EXPECT_EQ(trie.CountLess(high), 1);
+  EXPECT_EQ(trie.Kth(0), std::optional<Key>(5));
+  EXPECT_EQ(trie.Kth(2), std::optional<Key>(high | 3));
+  EXPECT_EQ(trie.Kth(3), std::optional<Key>(high << 20));
+  EXPECT_EQ(trie.MaxXor(high << 20),
+            std::optional<Key>((high << 20) | high | 3));
+  EXPECT_EQ(trie.MinXor(high), std::optional<Key>(3));
+
+  trie.XorAll(high);  // {high | 5, 3, 3, (high << 20) | high}
+  EXPECT_TRUE(trie.Contains(3));
+  EXPECT_EQ(trie.Kth(1), std::optional<Key>(3));
+  EXPECT_EQ(trie.Kth(2), std::optional<Key>(high | 5));
+  EXPECT_EQ(trie.CountLess(high), 2);
+
+  trie.Erase(3, 5);
+  EXPECT_EQ(trie.TotalCount(), 2);
+  EXPECT_EQ(trie.MinXor(0), std::optional<Key>(high | 5));
+}
+#endif  // __SIZEOF_INT128__
+
+TEST(WideBinaryTrieTest, MultiWordKeysApplyMaskPerWord) {
+  WideBinaryTrie<Key256> trie;
+  const Key256 a{1, 0, 0, 0};
+  const Key256 b{0, 0, 7, 0};
+  const Key256 c{0, 0, 0, 1ull << 63};
+  trie.Insert(a);
+  trie.Insert(b);
+  trie.Insert(c);
+
+  EXPECT_EQ(trie.CountLess(b), 1);
+  EXPECT_EQ(trie.Kth(2), std::optional<Key256>(c));
+  EXPECT_EQ(trie.MaxXor(Key256{}), std::optional<Key256>(c));
+  EXPECT_EQ(trie.MinXor(Key256{0, 0, 6, 0}),
+            std::optional<Key256>(Key256{0, 0, 1, 0}));
+
+  trie.XorAll(Key256{1, 0, 0, 1ull << 63});
+  EXPECT_TRUE(trie.Contains(Key256{0, 0, 0, 1ull << 63}));
+  EXPECT_TRUE(trie.Contains(Key256{1, 0, 7, 1ull << 63}));
+  EXPECT_EQ(trie.Kth(0), std::optional<Key256>(Key256{1, 0, 0, 0}));
+  EXPECT_EQ(trie.CountLess(Key256{0, 0, 0, 1}), 1);
+
+  WideBinaryTrie<Key256, 130> narrow;
+  narrow.Insert(Key256{0, 0, 3, 0});
+  EXPECT_EQ(narrow.MaxXor(Key256{0, 0, 1, 0}),
+            std::optional<Key256>(Key256{0, 0, 2, 0}));
+  EXPECT_FALSE(narrow.Kth(1).has_value());
+}
+
+}  // namespace
+}  // namespace hotaosa
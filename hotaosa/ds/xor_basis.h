@@ -0,0 +1,231 @@
+#ifndef HOTAOSA_DS_XOR_BASIS_H_
+#define HOTAOSA_DS_XOR_BASIS_H_
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hotaosa {
+
+// XorBasis is a linear basis over GF(2) of the values inserted so far,
+// answering subset-XOR questions: membership in the span, the extreme XOR
+// with a given value, and the k-th smallest span element. The basis is kept
+// in reduced row echelon form: basis_[b] is the only vector with bit b set
+// among the pivots, which turns Kth into reading the bits of k.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits>
+class XorBasis {
+  static_assert(kNumBits > 0, "XorBasis requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "XorBasis bit width exceeds ValueType digits");
+
+ public:
+  XorBasis() = default;
+
+  // Adds `value` to the generating set and returns whether the span grew.
+  // O(kNumBits).
+  bool Insert(ValueType value) {
+    assert((value & ~BitMask()) == 0);
+    value = Reduce(value);
+    if (value == 0) {
+      return false;
+    }
+    const int pivot = std::numeric_limits<ValueType>::digits - 1 -
+                      std::countl_zero(value);
+    // Clear the new pivot from every other vector to stay reduced.
+    for (int bit = pivot + 1; bit < kNumBits; ++bit) {
+      if (((basis_[bit] >> pivot) & 1) != 0) {
+        basis_[bit] ^= value;
+      }
+    }
+    basis_[pivot] = value;
+    ++rank_;
+    return true;
+  }
+
+  // Adds every vector of `other`. O(kNumBits^2).
+  void Merge(const XorBasis& other) {
+    for (const ValueType vector : other.basis_) {
+      if (vector != 0) {
+        Insert(vector);
+      }
+    }
+  }
+
+  // Dimension of the span; it holds 2^Rank() values. O(1).
+  [[nodiscard]] int Rank() const { return rank_; }
+
+  // Returns whether `value` is the XOR of some subset. O(kNumBits).
+  [[nodiscard]] bool Contains(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return Reduce(value) == 0;
+  }
+
+  // Returns the maximum of (`value` XOR s) over span elements s; the
+  // maximum subset XOR when `value` is 0. O(kNumBits).
+  [[nodiscard]] ValueType MaxXor(ValueType value = 0) const {
+    assert((value & ~BitMask()) == 0);
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      if (((value >> bit) & 1) == 0) {
+        value ^= basis_[bit];
+      }
+    }
+    return value;
+  }
+
+  // Returns the minimum of (`value` XOR s) over span elements s.
+  // O(kNumBits).
+  [[nodiscard]] ValueType MinXor(ValueType value) const {
+    assert((value & ~BitMask()) == 0);
+    return Reduce(value);
+  }
+
+  // Returns the k-th smallest (0-indexed) span element, where element 0 is
+  // the empty subset's 0, or nullopt when k >= 2^Rank(). O(kNumBits).
+  [[nodiscard]] std::optional<ValueType> Kth(ValueType k) const {
+    if (rank_ < std::numeric_limits<ValueType>::digits && (k >> rank_) != 0) {
+      return std::nullopt;
+    }
+    ValueType result = 0;
+    for (int bit = 0; bit < kNumBits && k != 0; ++bit) {
+      if (basis_[bit] != 0) {
+        if ((k & 1) != 0) {
+          result ^= basis_[bit];
+        }
+        k >>= 1;
+      }
+    }
+    return result;
+  }
+
+ private:
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // Eliminates every pivot bit of `value`.
+  [[nodiscard]] ValueType Reduce(ValueType value) const {
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      if (((value >> bit) & 1) != 0) {
+        value ^= basis_[bit];
+      }
+    }
+    return value;
+  }
+
+  // basis_[b]: the vector whose highest set bit is b, or 0.
+  std::array<ValueType, kNumBits> basis_{};
+  int rank_ = 0;
+};
+
+// PrefixXorBasis answers subset-XOR queries over subarrays a[l, r) of an
+// array built by PushBack. The basis of each prefix a[0, r) prefers the
+// latest elements: inserting a[i] swaps it in for any pivot vector built from
+// older positions. The subset XORs of a[l, r) are then exactly the span of
+// the prefix-r vectors whose position is >= l, so each query is one greedy
+// pass. Every prefix keeps its own snapshot, which costs
+// O(N * kNumBits) memory.
+template <std::unsigned_integral ValueType,
+          int kNumBits = std::numeric_limits<ValueType>::digits>
+class PrefixXorBasis {
+  static_assert(kNumBits > 0, "PrefixXorBasis requires at least one bit");
+  static_assert(kNumBits <= std::numeric_limits<ValueType>::digits,
+                "PrefixXorBasis bit width exceeds ValueType digits");
+
+ public:
+  PrefixXorBasis() : snapshots_(1) {}
+
+  // Appends `value` as a[Size()]. O(kNumBits).
+  void PushBack(ValueType value) {
+    assert((value & ~BitMask()) == 0);
+    Snapshot snapshot = snapshots_.back();
+    int position = Size();
+    for (int bit = kNumBits - 1; bit >= 0 && value != 0; --bit) {
+      if (((value >> bit) & 1) == 0) {
+        continue;
+      }
+      if (snapshot.basis[bit] == 0) {
+        snapshot.basis[bit] = value;
+        snapshot.positions[bit] = position;
+        break;
+      }
+      if (snapshot.positions[bit] < position) {
+        std::swap(snapshot.basis[bit], value);
+        std::swap(snapshot.positions[bit], position);
+      }
+      value ^= snapshot.basis[bit];
+    }
+    snapshots_.push_back(snapshot);
+  }
+
+  // Number of elements pushed. O(1).
+  [[nodiscard]] int Size() const {
+    return static_cast<int>(snapshots_.size()) - 1;
+  }
+
+  // Returns the maximum of (`value` XOR s) over subset XORs s of a[l, r).
+  // O(kNumBits).
+  [[nodiscard]] ValueType MaxXor(int l, int r, ValueType value = 0) const {
+    assert(0 <= l && l <= r && r <= Size());
+    assert((value & ~BitMask()) == 0);
+    const Snapshot& snapshot = snapshots_[r];
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      if (snapshot.positions[bit] >= l && ((value >> bit) & 1) == 0) {
+        value ^= snapshot.basis[bit];
+      }
+    }
+    return value;
+  }
+
+  // Returns whether `value` is the XOR of some subset of a[l, r).
+  // O(kNumBits).
+  [[nodiscard]] bool Contains(int l, int r, ValueType value) const {
+    assert(0 <= l && l <= r && r <= Size());
+    assert((value & ~BitMask()) == 0);
+    const Snapshot& snapshot = snapshots_[r];
+    for (int bit = kNumBits - 1; bit >= 0; --bit) {
+      if (snapshot.positions[bit] >= l && ((value >> bit) & 1) != 0) {
+        value ^= snapshot.basis[bit];
+      }
+    }
+    return value == 0;
+  }
+
+ private:
+  struct Snapshot {
+    // basis[b]: vector with highest set bit b, built from a[positions[b]]
+    // and later elements; positions[b] is -1 for an empty slot.
+    std::array<ValueType, kNumBits> basis{};
+    std::array<int, kNumBits> positions = EmptyPositions();
+  };
+
+  [[nodiscard]] static constexpr std::array<int, kNumBits> EmptyPositions() {
+    std::array<int, kNumBits> positions{};
+    positions.fill(-1);
+    return positions;
+  }
+
+  [[nodiscard]] static constexpr ValueType BitMask() {
+    if constexpr (kNumBits >= std::numeric_limits<ValueType>::digits) {
+      return std::numeric_limits<ValueType>::max();
+    } else {
+      return (ValueType{1} << kNumBits) - ValueType{1};
+    }
+  }
+
+  // snapshots_[r]: latest-position basis of a[0, r).
+  std::vector<Snapshot> snapshots_;
+};
+
+}  // namespace hotaosa
+
+#endif  // HOTAOSA_DS_XOR_BASIS_H_
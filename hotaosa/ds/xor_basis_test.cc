@@ -0,0 +1,98 @@
+#include "hotaosa/ds/xor_basis.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace hotaosa {
+namespace {
+
+// All subset XORs of `values`, in increasing order.
+std::vector<std::uint32_t> SubsetXors(
+    const std::vector<std::uint32_t>& values) {
+  std::set<std::uint32_t> span = {0};
+  for (const std::uint32_t value : values) {
+    std::set<std::uint32_t> next = span;
+    for (const std::uint32_t element : span) {
+      next.insert(element ^ value);
+    }
+    span = next;
+  }
+  return {span.begin(), span.end()};
+}
+
+TEST(XorBasisTest, SpanQueriesMatchBruteForce) {
+  const std::vector<std::uint32_t> values = {0b10110, 0b01101, 0b11011,
+                                             0b00111, 0b01000};
+  XorBasis<std::uint32_t, 5> basis;
+  EXPECT_TRUE(basis.Insert(values[0]));
+  EXPECT_TRUE(basis.Insert(values[1]));
+  EXPECT_FALSE(basis.Insert(values[2]));  // values[0] ^ values[1]
+  EXPECT_TRUE(basis.Insert(values[3]));
+  EXPECT_TRUE(basis.Insert(values[4]));
+  EXPECT_EQ(basis.Rank(), 4);
+
+  const std::vector<std::uint32_t> span = SubsetXors(values);
+  ASSERT_EQ(span.size(), 16u);
+  for (std::uint32_t k = 0; k < span.size(); ++k) {
+    EXPECT_EQ(basis.Kth(k), std::optional<std::uint32_t>(span[k]));
+  }
+  EXPECT_FALSE(basis.Kth(16).has_value());
+  EXPECT_EQ(basis.MaxXor(), span.back());
+  for (std::uint32_t value = 0; value < 32; ++value) {
+    const bool in_span = std::ranges::binary_search(span, value);
+    EXPECT_EQ(basis.Contains(value), in_span);
+    std::uint32_t best_max = 0;
+    std::uint32_t best_min = 31;
+    for (const std::uint32_t element : span) {
+      best_max = std::max(best_max, element ^ value);
+      best_min = std::min(best_min, element ^ value);
+    }
+    EXPECT_EQ(basis.MaxXor(value), best_max);
+    EXPECT_EQ(basis.MinXor(value), best_min);
+  }
+}
+
+TEST(XorBasisTest, MergeCombinesSpans) {
+  XorBasis<std::uint64_t> left;
+  XorBasis<std::uint64_t> right;
+  left.Insert(1ull << 63);
+  right.Insert(3);
+  right.Insert((1ull << 63) | 1);
+  left.Merge(right);
+  EXPECT_EQ(left.Rank(), 3);
+  EXPECT_TRUE(left.Contains(2));
+  EXPECT_EQ(left.MaxXor(), (1ull << 63) | 3);
+  EXPECT_EQ(left.Kth(7), std::optional<std::uint64_t>((1ull << 63) | 3));
+}
+
+TEST(PrefixXorBasisTest, RangeQueriesMatchBruteForce) {
+  const std::vector<std::uint32_t> values = {5, 9, 12, 5, 3, 30, 17, 9, 1};
+  PrefixXorBasis<std::uint32_t, 5> prefix;
+  for (const std::uint32_t value : values) {
+    prefix.PushBack(value);
+  }
+  ASSERT_EQ(prefix.Size(), static_cast<int>(values.size()));
+  for (int l = 0; l <= prefix.Size(); ++l) {
+    for (int r = l; r <= prefix.Size(); ++r) {
+      const std::vector<std::uint32_t> span =
+          SubsetXors({values.begin() + l, values.begin() + r});
+      EXPECT_EQ(prefix.MaxXor(l, r), span.back());
+      EXPECT_EQ(prefix.MaxXor(l, r, 7),
+                std::ranges::max(span, {}, [](std::uint32_t element) {
+                  return element ^ 7;
+                }) ^ 7);
+      for (std::uint32_t value = 0; value < 32; value += 3) {
+        EXPECT_EQ(prefix.Contains(l, r, value),
+                  std::ranges::binary_search(span, value));
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace hotaosa
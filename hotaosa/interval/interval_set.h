@@ -1,30 +1,325 @@
 #ifndef HOTAOSA_INTERVAL_INTERVAL_SET_H_
 #define HOTAOSA_INTERVAL_INTERVAL_SET_H_
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <concepts>
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <optional>
 #include <type_traits>
+#include <vector>
 
 #include <boost/icl/interval.hpp>
 #include <boost/icl/interval_set.hpp>
 
 namespace hotaosa {
 
-// IntervalSet offers a thin, contest-friendly facade over
-// boost::icl::interval_set for integral domains. The right-open [lower, upper)
-// interval is the default primitive, matching typical AtCoder-style half-open
-// ranges. Most operations run in O(log M), where M is the number of disjoint
-// intervals tracked by the set. For signed Key types, public APIs assert that
-// arguments are non-negative.
-template <std::integral Key, template <class> class Compare = std::less>
-class IntervalSet {
+// Storage policies for IntervalSet. IclBackend keeps the disjoint intervals
+// in boost::icl::interval_set, a node-based tree with O(log M) updates.
+// FlatBackend keeps their bounds in two sorted arrays: lookups are a
+// branchless binary search over contiguous memory and an interval costs
+// 2 * sizeof(Key) bytes, but updates shift the arrays in O(M), so it suits
+// read-heavy sets.
+struct IclBackend {};
+struct FlatBackend {};
+
+// Interval storage behind IntervalSet, specialized per backend. Intervals are
+// right-open, disjoint and never adjacent. Add and Subtract return how many
+// points they covered or uncovered.
+template <std::integral Key, template <class> class Compare, class Backend>
+class IntervalStorage;
+
+template <std::integral Key, template <class> class Compare>
+class IntervalStorage<Key, Compare, IclBackend> {
  public:
   using Impl = boost::icl::interval_set<Key, Compare>;
   using Interval = typename Impl::interval_type;
   using iterator = typename Impl::const_iterator;
   using size_type = typename Impl::size_type;
+
+  size_type Add(const Key& lower, const Key& upper) {
+    const size_type added = static_cast<size_type>(upper - lower) -
+                            CoveredWithin(lower, upper);
+    impl_.add(RightOpen(lower, upper));
+    return added;
+  }
+
+  size_type Subtract(const Key& lower, const Key& upper) {
+    const size_type removed = CoveredWithin(lower, upper);
+    if (removed != 0) {
+      impl_.subtract(RightOpen(lower, upper));
+    }
+    return removed;
+  }
+
+  void Clear() { impl_.clear(); }
+
+  // Upper bound of the interval containing `value`, if any.
+  [[nodiscard]] std::optional<Key> FindUpper(const Key& value) const {
+    const auto it = impl_.find(value);
+    if (it == impl_.end()) {
+      return std::nullopt;
+    }
+    return it->upper();
+  }
+
+  [[nodiscard]] bool Empty() const { return impl_.empty(); }
+
+  [[nodiscard]] iterator begin() const { return impl_.begin(); }
+  [[nodiscard]] iterator end() const { return impl_.end(); }
+
+  [[nodiscard]] const Impl& impl() const { return impl_; }
+  [[nodiscard]] Impl& impl() { return impl_; }
+
+ private:
+  static Interval RightOpen(const Key& lower, const Key& upper) {
+    return boost::icl::interval<Key>::right_open(lower, upper);
+  }
+
+  // Stored points inside [lower, upper). O(log M + k) over the k intervals
+  // it overlaps, which the caller's update merges or cuts anyway.
+  [[nodiscard]] size_type CoveredWithin(const Key& lower,
+                                        const Key& upper) const {
+    const Compare<Key> comp{};
+    const auto [first, last] = impl_.equal_range(RightOpen(lower, upper));
+    size_type covered = 0;
+    for (auto it = first; it != last; ++it) {
+      covered += static_cast<size_type>(std::min(it->upper(), upper, comp) -
+                                        std::max(it->lower(), lower, comp));
+    }
+    return covered;
+  }
+
+  Impl impl_;
+};
+
+template <std::integral Key, template <class> class Compare>
+class IntervalStorage<Key, Compare, FlatBackend> {
+ public:
+  using CompareType = Compare<Key>;
+  using Impl = IntervalStorage;
+  using size_type = std::size_t;
+
+  // A stored [lower, upper) interval, returned by value.
+  class Interval {
+   public:
+    Interval(Key lower, Key upper) : lower_(lower), upper_(upper) {}
+
+    [[nodiscard]] Key lower() const { return lower_; }
+    [[nodiscard]] Key upper() const { return upper_; }
+
+   private:
+    Key lower_;
+    Key upper_;
+  };
+
+  // Input iterator over the intervals in increasing order.
+  class ConstIterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Interval;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Interval;
+
+    ConstIterator() = default;
+
+    Interval operator*() const {
+      return Interval(storage_->lowers_[index_], storage_->uppers_[index_]);
+    }
+
+    ConstIterator& operator++() {
+      ++index_;
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      ConstIterator copy = *this;
+      ++index_;
+      return copy;
+    }
+
+    friend bool operator==(const ConstIterator& a, const ConstIterator& b) {
+      return a.index_ == b.index_;
+    }
+
+   private:
+    friend class IntervalStorage;
+
+    ConstIterator(const IntervalStorage* storage, std::size_t index)
+        : storage_(storage), index_(index) {}
+
+    const IntervalStorage* storage_ = nullptr;
+    std::size_t index_ = 0;
+  };
+  using iterator = ConstIterator;
+
+  // Merges [lower, upper) with every interval it overlaps or touches.
+  // O(log M + M).
+  size_type Add(Key lower, Key upper) {
+    const CompareType comp{};
+    const std::size_t first = CountBefore<false>(uppers_, lower);
+    const std::size_t last = CountBefore<true>(lowers_, upper);
+    const size_type added = static_cast<size_type>(upper - lower) -
+                            CoveredWithin(first, last, lower, upper);
+    if (first < last) {
+      lower = std::min(lower, lowers_[first], comp);
+      upper = std::max(upper, uppers_[last - 1], comp);
+    }
+    Replace(first, last, {lower, Key{}}, {upper, Key{}}, 1);
+    return added;
+  }
+
+  // Cuts [lower, upper) out of the intervals it overlaps. O(log M + M).
+  size_type Subtract(const Key& lower, const Key& upper) {
+    const CompareType comp{};
+    const std::size_t first = CountBefore<true>(uppers_, lower);
+    const std::size_t last = CountBefore<false>(lowers_, upper);
+    if (first >= last) {
+      return 0;
+    }
+    const size_type removed = CoveredWithin(first, last, lower, upper);
+    std::array<Key, 2> piece_lowers{};
+    std::array<Key, 2> piece_uppers{};
+    std::size_t count = 0;
+    if (comp(lowers_[first], lower)) {
+      piece_lowers[count] = lowers_[first];
+      piece_uppers[count++] = lower;
+    }
+    if (comp(upper, uppers_[last - 1])) {
+      piece_lowers[count] = upper;
+      piece_uppers[count++] = uppers_[last - 1];
+    }
+    Replace(first, last, piece_lowers, piece_uppers, count);
+    return removed;
+  }
+
+  void Clear() {
+    lowers_.clear();
+    uppers_.clear();
+  }
+
+  // Upper bound of the interval containing `value`, if any. O(log M).
+  [[nodiscard]] std::optional<Key> FindUpper(const Key& value) const {
+    const CompareType comp{};
+    const std::size_t index = CountBefore<true>(lowers_, value);
+    if (index == 0 || !comp(value, uppers_[index - 1])) {
+      return std::nullopt;
+    }
+    return uppers_[index - 1];
+  }
+
+  [[nodiscard]] bool Empty() const { return lowers_.empty(); }
+
+  [[nodiscard]] iterator begin() const { return ConstIterator(this, 0); }
+  [[nodiscard]] iterator end() const {
+    return ConstIterator(this, lowers_.size());
+  }
+
+  [[nodiscard]] const Impl& impl() const { return *this; }
+  [[nodiscard]] Impl& impl() { return *this; }
+
+ private:
+  // Number of leading `keys` below `value`, or not above it when
+  // kInclusive. The halving step selects with a conditional move instead of
+  // a branch, and prefetches both candidates for the next step.
+  template <bool kInclusive>
+  [[nodiscard]] static std::size_t CountBefore(const std::vector<Key>& keys,
+                                               const Key& value) {
+    const CompareType comp{};
+    const auto before = [&](const Key& key) {
+      return kInclusive ? !comp(value, key) : comp(key, value);
+    };
+    std::size_t length = keys.size();
+    if (length == 0) {
+      return 0;
+    }
+    std::size_t base = 0;
+    while (length > 1) {
+      const std::size_t half = length / 2;
+#if defined(__GNUC__) || defined(__clang__)
+      // Both possible next probes, so the loads overlap the comparison.
+      __builtin_prefetch(&keys[base + half / 2]);
+      __builtin_prefetch(&keys[base + half + half / 2]);
+#endif
+      base = before(keys[base + half]) ? base + half : base;
+      length -= half;
+    }
+    return base + static_cast<std::size_t>(before(keys[base]));
+  }
+
+  // Points of the intervals [first, last) inside [lower, upper).
+  [[nodiscard]] size_type CoveredWithin(std::size_t first,
+                                        std::size_t last,
+                                        const Key& lower,
+                                        const Key& upper) const {
+    const CompareType comp{};
+    size_type covered = 0;
+    for (std::size_t i = first; i < last; ++i) {
+      const Key overlap_lower = std::max(lowers_[i], lower, comp);
+      const Key overlap_upper = std::min(uppers_[i], upper, comp);
+      if (comp(overlap_lower, overlap_upper)) {
+        covered += static_cast<size_type>(overlap_upper - overlap_lower);
+      }
+    }
+    return covered;
+  }
+
+  // Replaces the intervals [first, last) by the first `count` pieces.
+  void Replace(std::size_t first,
+               std::size_t last,
+               const std::array<Key, 2>& piece_lowers,
+               const std::array<Key, 2>& piece_uppers,
+               std::size_t count) {
+    const std::size_t reused = std::min(last - first, count);
+    for (std::size_t i = 0; i < reused; ++i) {
+      lowers_[first + i] = piece_lowers[i];
+      uppers_[first + i] = piece_uppers[i];
+    }
+    const auto offset = static_cast<std::ptrdiff_t>(first + reused);
+    if (last - first > count) {
+      const auto end = static_cast<std::ptrdiff_t>(last);
+      lowers_.erase(lowers_.begin() + offset, lowers_.begin() + end);
+      uppers_.erase(uppers_.begin() + offset, uppers_.begin() + end);
+    } else if (count > reused) {
+      lowers_.insert(lowers_.begin() + offset, piece_lowers.begin() + reused,
+                     piece_lowers.begin() + count);
+      uppers_.insert(uppers_.begin() + offset, piece_uppers.begin() + reused,
+                     piece_uppers.begin() + count);
+    }
+  }
+
+  // lowers_[i] and uppers_[i] bound the i-th interval in increasing order.
+  std::vector<Key> lowers_;
+  std::vector<Key> uppers_;
+};
+
+// IntervalSet offers a thin, contest-friendly facade over
+// boost::icl::interval_set for integral domains, or over sorted bound arrays
+// with the FlatBackend policy. The right-open [lower, upper) interval is the
+// default primitive, matching typical AtCoder-style half-open ranges. Most
+// operations run in O(log M), where M is the number of disjoint intervals
+// tracked by the set; FlatBackend updates are O(M). The covered measure is
+// maintained by every update, so Size is O(1) and Add/Erase report their
+// change to it. For signed Key types, public APIs assert that arguments are
+// non-negative.
+//
+// Compare must order keys like std::less: the measure of [lower, upper) is
+// taken as upper - lower, and single points as [value, value + 1).
+template <std::integral Key,
+          template <class> class Compare = std::less,
+          class Backend = IclBackend>
+class IntervalSet {
+ public:
+  using Storage = IntervalStorage<Key, Compare, Backend>;
+  using Impl = typename Storage::Impl;
+  using Interval = typename Storage::Interval;
+  using iterator = typename Storage::iterator;
+  using size_type = typename Storage::size_type;
   using CompareType = Compare<Key>;
   using value_type = Key;
 
@@ -36,98 +331,95 @@ class IntervalSet {
   IntervalSet& operator=(IntervalSet&&) = default;
   ~IntervalSet() = default;
 
-  // Adds [lower, upper) to the set. O(log M).
-  void Add(const Key& lower, const Key& upper) {
+  // Adds [lower, upper) to the set and returns how many points became
+  // covered. O(log M) amortized: the intervals it overlaps are merged away.
+  size_type Add(const Key& lower, const Key& upper) {
     const CompareType comp{};
     CheckNonNegative(lower);
     CheckNonNegative(upper);
     assert(!comp(upper, lower));
     if (!comp(lower, upper)) {
-      return;
+      return 0;
     }
-    impl_.add(RightOpen(lower, upper));
+    const size_type added = storage_.Add(lower, upper);
+    size_ += added;
+    return added;
   }
 
-  // Adds single `value`, interpreted as [value, value + 1). O(log M).
-  void Add(const Key& value) {
+  // Adds single `value`, interpreted as [value, value + 1); returns 1 when
+  // it was not covered yet. O(log M).
+  size_type Add(const Key& value) {
     CheckNonNegative(value);
-    impl_.add(RightOpen(value));
+    const size_type added = storage_.Add(value, NextValue(value));
+    size_ += added;
+    return added;
   }
 
   // Replaces the current contents with exactly [lower, upper). O(log M).
   void Assign(const Key& lower, const Key& upper) {
     CheckNonNegative(lower);
     CheckNonNegative(upper);
-    impl_.clear();
+    Clear();
     Add(lower, upper);
   }
 
   // Replaces the current contents with the single element `value`. O(log M).
   void Assign(const Key& value) {
     CheckNonNegative(value);
-    impl_.clear();
+    Clear();
     Add(value);
   }
 
-  // Removes [lower, upper) when present. O(log M).
-  void Erase(const Key& lower, const Key& upper) {
+  // Removes [lower, upper) when present and returns how many points became
+  // uncovered. O(log M) amortized.
+  size_type Erase(const Key& lower, const Key& upper) {
     const CompareType comp{};
     CheckNonNegative(lower);
     CheckNonNegative(upper);
     assert(!comp(upper, lower));
     if (!comp(lower, upper)) {
-      return;
+      return 0;
     }
-    impl_.subtract(RightOpen(lower, upper));
+    const size_type removed = storage_.Subtract(lower, upper);
+    size_ -= removed;
+    return removed;
   }
 
-  // Removes single `value`, interpreted as [value, value + 1). O(log M).
-  void Erase(const Key& value) {
+  // Removes single `value`, interpreted as [value, value + 1); returns 1
+  // when it was covered. O(log M).
+  size_type Erase(const Key& value) {
     CheckNonNegative(value);
-    impl_.subtract(RightOpen(value));
+    const size_type removed = storage_.Subtract(value, NextValue(value));
+    size_ -= removed;
+    return removed;
   }
 
   // Returns whether `value` is contained in any stored interval. O(log M).
   [[nodiscard]] bool Contains(const Key& value) const {
     CheckNonNegative(value);
-    return impl_.find(value) != impl_.end();
+    return storage_.FindUpper(value).has_value();
   }
 
   // Returns the smallest non-negative value that is not covered; O(1).
   [[nodiscard]] Key Mex() const {
-    if (impl_.empty()) {
+    if (storage_.Empty()) {
       return static_cast<Key>(0);
     }
-    const auto first = impl_.begin();
-    return first->lower() == static_cast<Key>(0) ? first->upper()
-                                                 : static_cast<Key>(0);
+    const Interval first = *storage_.begin();
+    return first.lower() == static_cast<Key>(0) ? first.upper()
+                                                : static_cast<Key>(0);
   }
 
-  // Returns the smallest value >= start that is not covered. O(log M).
+  // Returns the smallest value >= start that is not covered. Adjacent
+  // intervals are merged, so it is the end of the interval covering `start`,
+  // if any. O(log M).
   [[nodiscard]] Key Mex(Key start) const {
-    const CompareType comp{};
     if constexpr (std::is_signed_v<Key>) {
       if (start < static_cast<Key>(0)) {
         start = static_cast<Key>(0);
       }
     }
-    const auto covering = impl_.find(start);
-    if (covering != impl_.end()) {
-      return covering->upper();
-    }
-    const Key kMax = std::numeric_limits<Key>::max();
-    if (start == kMax) {
-      return start;
-    }
-    const auto next = impl_.lower_bound(RightOpen(start, NextValue(start)));
-    if (next == impl_.end()) {
-      return start;
-    }
-    const Key lower = next->lower();
-    if (comp(start, lower)) {
-      return start;
-    }
-    return next->upper();
+    return storage_.FindUpper(start).value_or(start);
   }
 
   // Returns whether the whole [lower, upper) range is covered. O(log M).
@@ -137,40 +429,35 @@ class IntervalSet {
     if (!comp(lower, upper)) {
       return true;
     }
-    const auto it = impl_.find(lower);
-    if (it == impl_.end()) {
-      return false;
-    }
-    return !comp(it->upper(), upper);
+    const std::optional<Key> covered_upper = storage_.FindUpper(lower);
+    return covered_upper.has_value() && !comp(*covered_upper, upper);
   }
 
   // Returns true when no interval is stored. O(1).
-  [[nodiscard]] bool Empty() const { return impl_.empty(); }
+  [[nodiscard]] bool Empty() const { return storage_.Empty(); }
 
-  // Returns the total cardinality/measure; O(M) over disjoint segments.
-  [[nodiscard]] size_type Size() const { return impl_.size(); }
+  // Returns the total cardinality/measure. O(1).
+  [[nodiscard]] size_type Size() const { return size_; }
 
-  [[nodiscard]] iterator begin() const { return impl_.begin(); }
-  [[nodiscard]] iterator end() const { return impl_.end(); }
+  [[nodiscard]] iterator begin() const { return storage_.begin(); }
+  [[nodiscard]] iterator end() const { return storage_.end(); }
 
-  [[nodiscard]] const Impl& impl() const { return impl_; }
-  [[nodiscard]] Impl& impl() { return impl_; }
+  // Read-only access to the backing storage; writes must go through the
+  // facade to keep Size in sync.
+  [[nodiscard]] const Impl& impl() const { return storage_.impl(); }
 
  private:
+  void Clear() {
+    storage_.Clear();
+    size_ = 0;
+  }
+
   static void CheckNonNegative(const Key& value) {
     if constexpr (std::is_signed_v<Key>) {
       assert(value >= static_cast<Key>(0));
     }
   }
 
-  static Interval RightOpen(const Key& lower, const Key& upper) {
-    return boost::icl::interval<Key>::right_open(lower, upper);
-  }
-
-  static Interval RightOpen(const Key& value) {
-    return RightOpen(value, NextValue(value));
-  }
-
   static Key NextValue(const Key& value) {
     [[maybe_unused]] constexpr Key kMax = std::numeric_limits<Key>::max();
     if constexpr (std::is_signed_v<Key>) {
@@ -181,7 +468,9 @@ class IntervalSet {
     return static_cast<Key>(value + static_cast<Key>(1));
   }
 
-  Impl impl_;
+  Storage storage_;
+  // Covered measure, the summed lengths of the stored intervals.
+  size_type size_ = 0;
 };
 
 }  // namespace hotaosa
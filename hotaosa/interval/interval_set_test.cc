@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <functional>
 #include <utility>
 #include <vector>
 
@@ -106,4 +108,110 @@ TEST(IntervalSetTest, MexQueries) {
   EXPECT_EQ(intervals.Mex(12), 15);
 }
 
+TEST(IntervalSetTest, FlatBackendBasics) {
+  hotaosa::IntervalSet<int, std::less, hotaosa::FlatBackend> intervals;
+  EXPECT_TRUE(intervals.Empty());
+  EXPECT_EQ(intervals.Mex(), 0);
+
+  intervals.Add(2, 5);
+  intervals.Add(8, 10);
+  intervals.Add(5, 6);  // touches [2, 5)
+  intervals.Add(0);
+  EXPECT_EQ(intervals.Size(), 7);
+  EXPECT_EQ(intervals.Mex(), 1);
+  EXPECT_EQ(intervals.Mex(3), 6);
+  EXPECT_TRUE(intervals.Covers(2, 6));
+  EXPECT_FALSE(intervals.Covers(5, 9));
+
+  intervals.Erase(3, 9);
+  std::vector<std::pair<int, int>> segments;
+  for (const auto& interval : intervals) {
+    segments.emplace_back(interval.lower(), interval.upper());
+  }
+  EXPECT_EQ(segments,
+            (std::vector<std::pair<int, int>>{{0, 1}, {2, 3}, {9, 10}}));
+
+  intervals.Assign(4, 7);
+  EXPECT_FALSE(intervals.Contains(2));
+  EXPECT_TRUE(intervals.Contains(6));
+  EXPECT_EQ(intervals.Size(), 3);
+}
+
+TEST(IntervalSetTest, FlatBackendMatchesIclBackend) {
+  hotaosa::IntervalSet<unsigned> icl;
+  hotaosa::IntervalSet<unsigned, std::less, hotaosa::FlatBackend> flat;
+  unsigned state = 17;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) % 200u;
+  };
+  for (int step = 0; step < 2000; ++step) {
+    const unsigned a = next();
+    const unsigned b = a + next() % 20u;
+    if (step % 3 == 0) {
+      icl.Erase(a, b);
+      flat.Erase(a, b);
+    } else {
+      icl.Add(a, b);
+      flat.Add(a, b);
+    }
+    ASSERT_EQ(flat.Size(), icl.Size());
+    ASSERT_EQ(flat.Mex(), icl.Mex());
+    const unsigned probe = next();
+    ASSERT_EQ(flat.Contains(probe), icl.Contains(probe));
+    ASSERT_EQ(flat.Mex(probe), icl.Mex(probe));
+    ASSERT_EQ(flat.Covers(probe, probe + 3), icl.Covers(probe, probe + 3));
+  }
+  std::vector<std::pair<unsigned, unsigned>> icl_segments;
+  for (const auto& interval : icl) {
+    icl_segments.emplace_back(interval.lower(), interval.upper());
+  }
+  std::vector<std::pair<unsigned, unsigned>> flat_segments;
+  for (const auto& interval : flat) {
+    flat_segments.emplace_back(interval.lower(), interval.upper());
+  }
+  EXPECT_EQ(flat_segments, icl_segments);
+}
+
+template <class Set>
+void ExpectMeasureDeltasMatchBruteForce() {
+  Set intervals;
+  std::vector<bool> covered(260, false);
+  int size = 0;
+  unsigned state = 41;
+  const auto next = [&state] {
+    state = state * 1103515245u + 12345u;
+    return static_cast<int>((state >> 8) % 240u);
+  };
+  for (int step = 0; step < 3000; ++step) {
+    const int lower = next();
+    const int upper = lower + next() % 17;
+    const bool erase = step % 3 == 0;
+    int expected = 0;
+    for (int x = lower; x < upper; ++x) {
+      if (covered[x] == erase) {
+        ++expected;
+        covered[x] = !erase;
+      }
+    }
+    size += erase ? -expected : expected;
+    const auto delta = erase ? intervals.Erase(lower, upper)
+                             : intervals.Add(lower, upper);
+    ASSERT_EQ(delta, static_cast<std::size_t>(expected)) << step;
+    ASSERT_EQ(intervals.Size(), static_cast<std::size_t>(size)) << step;
+  }
+  EXPECT_EQ(intervals.Add(258), 1u);
+  EXPECT_EQ(intervals.Add(258), 0u);
+  EXPECT_EQ(intervals.Erase(258), 1u);
+  EXPECT_EQ(intervals.Erase(258), 0u);
+  intervals.Assign(3, 9);
+  EXPECT_EQ(intervals.Size(), 6u);
+}
+
+TEST(IntervalSetTest, AddAndEraseReportMeasureChanges) {
+  ExpectMeasureDeltasMatchBruteForce<hotaosa::IntervalSet<int>>();
+  ExpectMeasureDeltasMatchBruteForce<
+      hotaosa::IntervalSet<int, std::less, hotaosa::FlatBackend>>();
+}
+
 }  // namespace